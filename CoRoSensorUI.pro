@@ -48,14 +48,53 @@ SOURCES += src/main.cpp\
     src/mainwindow.cpp \
     src/connection.cpp \
     src/communicator.cpp \
+    src/port_scanner.cpp \
+    src/usb_protocol.cpp \
+    src/usb_framer.cpp \
+    src/serial_link.cpp \
+    src/sample_clock.cpp \
+    src/finger_history.cpp \
+    src/history_pyramid.cpp \
+    src/decimate.cpp \
+    src/graph_renderer.cpp \
+    src/heatmap.cpp \
+    src/plot_widget.cpp \
+    src/strip_chart.cpp \
+    src/spectrum.cpp \
+    src/spectrogram.cpp \
+    src/filter.cpp \
+    src/contact_detector.cpp \
+    src/static_baseline.cpp \
+    src/replay.cpp \
     src/graphics.cpp \
     src/log.cpp
 
 HEADERS += src/mainwindow.h \
     src/communicator.h \
+    src/port_scanner.h \
+    src/device.h \
+    src/usb_protocol.h \
+    src/usb_framer.h \
+    src/serial_link.h \
+    src/sample_clock.h \
+    src/replay.h \
     src/circular_buffer.h \
+    src/finger_history.h \
+    src/history_pyramid.h \
+    src/decimate.h \
+    src/graph_renderer.h \
+    src/heatmap.h \
+    src/plot_widget.h \
+    src/strip_chart.h \
+    src/spectrum.h \
+    src/spectrogram.h \
+    src/filter.h \
+    src/contact_detector.h \
+    src/static_baseline.h \
     src/finger_data.h
 
+linux: SOURCES += src/serial_link_posix.cpp
+
 FORMS += src/mainwindow.ui
 
 RESOURCES += \
@@ -19,143 +19,233 @@
 #ifndef CIRCULAR_BUFFER_H
 #define CIRCULAR_BUFFER_H
 
-#include <QMutex>
-#include <QVector>
+#include <QAtomicInteger>
 #include <vector>
+#include <stddef.h>
+#include <stdint.h>
 
-template<typename T>
-class SafeCircularBuffer
+/*
+ * Sequencing of a ring buffer with a single writer and any number of readers, none of which ever take a lock.
+ *
+ * Items are numbered by a sequence that only increases.  The writer announces the range it is about to overwrite
+ * (claim), writes the items and then publishes them.  Readers copy what they want and then check with intactFrom()
+ * whether the writer may have overwritten some of it in the mean time, in which case that part of the copy is dropped.
+ * The writer therefore never waits for slow readers; readers instead detect that they have been overrun.
+ *
+ * The storage is up to the user, so the same sequencing serves a ring of structs as well as a ring of columns.  Items
+ * must be plain copyable types, since a reader may copy an item while it is being overwritten (and then discard it).
+ */
+class RingSequencer
 {
 public:
-    SafeCircularBuffer(size_t size): buffer(size), start(0), count(0) {}
-    ~SafeCircularBuffer() {}
+    RingSequencer(size_t size_): size(size_), head(0), claimed(0) {}
 
-    size_t size()
-    {
-        size_t s;
+    size_t capacity() const { return size; }
 
-        mutex.lock();
-        s = count;
-        mutex.unlock();
+    // Number of items ever published; the items [sequence() - capacity(), sequence()) are available
+    uint64_t sequence() const { return head.loadAcquire(); }
 
-        return s;
+    // Writer side: announce that count items are about to be written, starting at the returned sequence number
+    uint64_t claim(size_t count)
+    {
+        uint64_t h = head.load();
+        claimed.fetchAndStoreOrdered(h + count);
+        return h;
     }
 
-    bool empty() { return size() == 0; }
+    void publish(uint64_t end) { head.storeRelease(end); }
 
-    void push(const T &t)
+    // Reader side: the available items after sequence number since, limited to the newest count if count is not 0
+    void available(uint64_t since, size_t count, uint64_t &from, uint64_t &to) const
     {
-        mutex.lock();
+        to = sequence();
+        from = to > size?to - size:0;
+        if (count != 0 && to > count && to - count > from)
+            from = to - count;
+        if (since > from)
+            from = since < to?since:to;
+    }
 
-        buffer[(start + count) % buffer.size()] = t;
+    // First sequence number that the writer has not touched yet.  The read-modify-write is a full barrier, so the
+    // reads done before calling this are complete by the time claimed is looked at.
+    uint64_t intactFrom() const
+    {
+        uint64_t c = claimed.fetchAndAddOrdered(0);
+        return c > size?c - size:0;
+    }
 
-        // If buffer is already full, throw away the oldest data
-        if (count == buffer.size())
-            start = (start + 1) % buffer.size();
-        // Otherwise just indicate that there is more data
-        else
-            ++count;
+private:
+    size_t size;
+    QAtomicInteger<quint64> head;               // Next item to write
+    mutable QAtomicInteger<quint64> claimed;    // Items before this may be being written
+};
 
-        mutex.unlock();
+/*
+ * A reader cursor on a ring.  Every reader keeps its own cursor, so for example the plots can look at the latest data
+ * without consuming it while the logger consumes everything exactly once.  A reader must only be used by one thread.
+ *
+ * The ring must provide sequence(), capacity() and copy(from, to, out), the latter returning the first sequence number
+ * whose copy is intact.
+ */
+template<typename Ring, typename T>
+class RingReader
+{
+public:
+    RingReader(const Ring &ring_): ring(ring_), cursor(ring_.sequence()), lost(0) {}
+
+    // Whether there is nothing to read; without consuming, there is nothing only if nothing was ever pushed
+    bool empty(bool consume = false) const { return ring.sequence() == (consume?cursor:0); }
+
+    // Newest item, without consuming
+    bool back(T &t) const
+    {
+        uint64_t to = ring.sequence();
+        if (to == 0)
+            return false;
+        return ring.copy(to - 1, to, &t) == to - 1;
     }
 
-    T pop()
+    // Copy all available items (or only those not yet consumed), oldest first.  Returns the number of items.
+    size_t extract(std::vector<T> &vec, bool consume = false)
     {
-        T t;
+        uint64_t to = ring.sequence();
+        uint64_t from = to > ring.capacity()?to - ring.capacity():0;
+        if (consume && cursor > from)
+            from = cursor;
 
-        mutex.lock();
+        vec.resize(to - from);
+        uint64_t first = ring.copy(from, to, vec.data());
+        if (first > from)
+            vec.erase(vec.begin(), vec.begin() + (first - from));
 
-        // They shouldn't call this function with empty buffer, so fail in this case
-        if (count == 0)
+        if (consume)
         {
-            mutex.unlock();
-            return t;
+            if (first > cursor)
+                lost += first - cursor;
+            cursor = to;
         }
 
-        t = buffer[start];
+        return vec.size();
+    }
 
-        start = (start + 1) % buffer.size();
-        --count;
+    /*
+     * Copy only the items after sequence number since, without consuming.  Returns the sequence number of the first
+     * copied item, which is larger than since if the older items are already overwritten.
+     */
+    uint64_t extract(uint64_t since, std::vector<T> &vec) const
+    {
+        uint64_t to = ring.sequence();
+        uint64_t from = to > ring.capacity()?to - ring.capacity():0;
+        if (since > from)
+            from = since < to?since:to;
 
-        mutex.unlock();
+        vec.resize(to - from);
+        uint64_t first = ring.copy(from, to, vec.data());
+        if (first > from)
+            vec.erase(vec.begin(), vec.begin() + (first - from));
 
-        return t;
+        return first;
     }
 
-    T front()       // Oldest data
-    {
-        T t;
+    // Skip everything that was not yet consumed
+    void clear() { cursor = ring.sequence(); }
 
-        mutex.lock();
+    // Number of items that were overwritten before this reader could consume them
+    uint64_t overruns() const { return lost; }
 
-        // They shouldn't call this function with empty buffer, so fail in this case
-        if (count == 0)
-        {
-            mutex.unlock();
-            return t;
-        }
-
-        t = buffer[start];
+private:
+    const Ring &ring;
+    uint64_t cursor;    // Next item to consume
+    uint64_t lost;
+};
 
-        mutex.unlock();
+/*
+ * A view of a range of a ring without copying it.  The range may wrap around the end of the buffer, so it is made of
+ * two contiguous segments.  Since the writer doesn't wait for anyone, the view must be checked with the ring's
+ * intact() after use, and discarded if the writer has overwritten part of it meanwhile.
+ */
+template<typename T>
+struct RingSpan
+{
+    const T *first, *second;
+    size_t firstCount, secondCount;
+    uint64_t start;     // Sequence number of the first item
 
-        return t;
-    }
+    size_t size() const { return firstCount + secondCount; }
+    const T &operator[](size_t i) const { return i < firstCount?first[i]:second[i - firstCount]; }
 
-    T back()        // Newest data
+    // View [from, to) of a ring stored in buffer, which holds size items
+    static RingSpan of(const T *buffer, size_t size, uint64_t from, uint64_t to)
     {
-        T t;
-
-        mutex.lock();
+        size_t begin = from % size;
+        size_t n = to - from;
+
+        RingSpan s;
+        s.start = from;
+        s.first = buffer + begin;
+        s.firstCount = n < size - begin?n:size - begin;
+        s.second = buffer;
+        s.secondCount = n - s.firstCount;
+        return s;
+    }
+};
 
-        // They shouldn't call this function with empty buffer, so fail in this case
-        if (count == 0)
-        {
-            mutex.unlock();
-            return t;
-        }
+/*
+ * A lock-free ring of items, with a single writer and any number of readers.
+ */
+template<typename T>
+class SpmcRing
+{
+public:
+    typedef RingReader<SpmcRing<T>, T> Reader;
+    typedef RingSpan<T> Span;
 
-        t = buffer[(start + count - 1) % buffer.size()];
+    SpmcRing(size_t size): sequencer(size), buffer(size) {}
+    ~SpmcRing() {}
 
-        mutex.unlock();
+    size_t capacity() const { return buffer.size(); }
+    uint64_t sequence() const { return sequencer.sequence(); }
 
-        return t;
+    // Writer side, to be called from a single thread
+    void push(const T &t)
+    {
+        uint64_t h = sequencer.claim(1);
+        buffer[h % buffer.size()] = t;
+        sequencer.publish(h + 1);
     }
 
-    void clear()
+    void push(const std::vector<T> &items)
     {
-        mutex.lock();
-        start = count = 0;
-        mutex.unlock();
+        uint64_t h = sequencer.claim(items.size());
+        for (size_t i = 0; i < items.size(); ++i)
+            buffer[(h + i) % buffer.size()] = items[i];
+        sequencer.publish(h + items.size());
     }
 
-    void extract(QVector<T> &vec, bool consume = false)
+    // View the items after sequence number since (or the last count items if since is 0), without copying
+    Span span(uint64_t since, size_t count = 0) const
     {
-        mutex.lock();
-        vec.resize(count);
-        for (size_t i = 0; i < count; ++i)
-            vec[i] = buffer[(start + i) % buffer.size()];
-        if (consume)
-            start = count = 0;
-        mutex.unlock();
+        uint64_t from, to;
+        sequencer.available(since, count, from, to);
+        return Span::of(&buffer[0], buffer.size(), from, to);
     }
 
-    void extract(std::vector<T> &vec, bool consume = false)
+    // Whether the items of a span were left untouched by the writer until now
+    bool intact(const Span &s) const { return sequencer.intactFrom() <= s.start; }
+
+    // Copy [from, to) to out and return the first sequence number whose copy is known to be intact
+    uint64_t copy(uint64_t from, uint64_t to, T *out) const
     {
-        mutex.lock();
-        vec.resize(count);
-        for (size_t i = 0; i < count; ++i)
-            vec[i] = buffer[(start + i) % buffer.size()];
-        if (consume)
-            start = count = 0;
-        mutex.unlock();
+        for (uint64_t s = from; s < to; ++s)
+            out[s - from] = buffer[s % buffer.size()];
+
+        uint64_t intact = sequencer.intactFrom();
+        return intact > from?(intact < to?intact:to):from;
     }
 
 private:
-    QMutex mutex;
+    RingSequencer sequencer;
     std::vector<T> buffer;
-    size_t start;   // Next item to read
-    size_t count;   // read + count is next item to write
 };
 
 #endif // CIRCULAR_BUFFER_H
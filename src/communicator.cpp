@@ -17,100 +17,23 @@
  */
 
 #include "communicator.h"
+#include "device.h"
 #include <QTime>
 #include <QApplication>
+#include <math.h>
 
-enum UsbPacketSpecial
+static void usbSend(SerialLink *link, UsbPacket *packet)
 {
-    USB_PACKET_START_BYTE = 0x9A,
-};
-
-enum UsbCommands
-{
-    USB_COMMAND_READ_SENSORS = 0x61,
-    USB_COMMAND_AUTOSEND_SENSORS = 0x58,
-
-    USB_COMMAND_ENTER_BOOTLOADER = 0xE2,
-};
-
-// Sensor types occupy the higher 4 bits, the 2 bits lower than that identify finger, and the lower 2 bits is used as an index.
-enum UsbSensorType
-{
-    USB_SENSOR_TYPE_STATIC_TACTILE = 0x10,
-    USB_SENSOR_TYPE_DYNAMIC_TACTILE = 0x20,
-    USB_SENSOR_TYPE_ACCELEROMETER = 0x30,
-    USB_SENSOR_TYPE_GYROSCOPE = 0x40,
-    USB_SENSOR_TYPE_MAGNETOMETER = 0x50,
-    USB_SENSOR_TYPE_TEMPERATURE = 0x60,
-};
-
-struct UsbPacket
-{
-    uint8_t start_byte;
-    uint8_t crc8;           // over command, data_length and data
-    uint8_t command;        // 4 bits of flag (MSB) and 4 bits of command (LSB)
-    uint8_t data_length;
-    uint8_t data[60];
-};
-
-static uint8_t calcCrc8(uint8_t *data, size_t len)
-{
-    // TODO: calculate CRC8
-    return data[-1];
-}
-
-static void usbSend(QSerialPort *port, UsbPacket *packet)
-{
-    uint8_t *p = (uint8_t *)packet;
-
-    packet->start_byte = USB_PACKET_START_BYTE;
-    packet->crc8 = calcCrc8(p + 2, packet->data_length + 2);
-
-    port->write((char *)p, packet->data_length + 4);
-    port->waitForBytesWritten(1);
-}
-
-static bool usbReadByte(UsbPacket *packet, unsigned int *readSoFar, uint8_t d)
-{
-    uint8_t *p = (uint8_t *)packet;
-
-    // Make sure start byte is seen
-    if (*readSoFar == 0 && d != USB_PACKET_START_BYTE)
-        return false;
-
-    // Buffer the byte (making sure not to overflow the packet)
-    if (*readSoFar < 64)
-        p[*readSoFar] = d;
-    ++*readSoFar;
-
-    // If length is read, stop when done
-    if (*readSoFar > 3 && *readSoFar >= (unsigned)packet->data_length + 4)
-    {
-        *readSoFar = 0;
-
-        // If CRC is ok, we have a new packet!  Return it.
-        if (packet->crc8 == calcCrc8(p + 2, packet->data_length + 2))
-            return true;
-
-        // If CRC is not ok, find the next start byte and shift the packet back in hopes of getting back in sync
-        for (unsigned int i = 1; i < (unsigned)packet->data_length + 4; ++i)
-            if (p[i] == USB_PACKET_START_BYTE)
-            {
-                memmove(p, p + i, packet->data_length + 4 - i);
-                *readSoFar = packet->data_length + 4 - i;
-                break;
-            }
-    }
-
-    return false;
+    size_t size = usbFinalizePacket(packet);
+    link->write((char *)packet, size);
 }
 
-static inline uint16_t parseBigEndian2(uint8_t *data)
+static inline uint16_t parseBigEndian2(const uint8_t *data)
 {
     return (uint16_t)data[0] << 8 | data[1];
 }
 
-static uint8_t extractUint16(uint16_t *to, uint16_t toCount, uint8_t *data, unsigned int size)
+static uint8_t extractUint16(uint16_t *to, uint16_t toCount, const uint8_t *data, unsigned int size)
 {
     unsigned int cur;
 
@@ -122,38 +45,42 @@ static uint8_t extractUint16(uint16_t *to, uint16_t toCount, uint8_t *data, unsi
     return cur * 2;
 }
 
-static bool parseSensors(UsbPacket *packet, Fingers *fingers)
+static bool parseSensors(const UsbPacket *packet, Fingers *fingers)
 {
     bool sawDynamic = false;
+    FingerData unused;
     for (unsigned int i = 0; i < packet->data_length;)
     {
         uint8_t sensorType = packet->data[i] & 0xF0;
         uint8_t f= packet->data[i] >> 2 & 0x03;
         ++i;
 
-        uint8_t *sensorData = packet->data + i;
+        const uint8_t *sensorData = packet->data + i;
         unsigned int sensorDataBytes = packet->data_length - i;
 
+        // The protocol can address more fingers than we show.  Their data still needs to be skipped over.
+        FingerData *finger = f < FINGER_COUNT?&fingers->finger[f]:&unused;
+
         switch (sensorType)
         {
         case USB_SENSOR_TYPE_DYNAMIC_TACTILE:
-            i += extractUint16((uint16_t *)fingers->finger[f].dynamicTactile, FINGER_DYNAMIC_TACTILE_COUNT, sensorData, sensorDataBytes);
+            i += extractUint16((uint16_t *)finger->dynamicTactile, FINGER_DYNAMIC_TACTILE_COUNT, sensorData, sensorDataBytes);
             sawDynamic = true;
             break;
         case USB_SENSOR_TYPE_STATIC_TACTILE:
-            i += extractUint16(fingers->finger[f].staticTactile, FINGER_STATIC_TACTILE_COUNT, sensorData, sensorDataBytes);
+            i += extractUint16(finger->staticTactile, FINGER_STATIC_TACTILE_COUNT, sensorData, sensorDataBytes);
             break;
         case USB_SENSOR_TYPE_ACCELEROMETER:
-            i += extractUint16((uint16_t *)fingers->finger[f].accelerometer, 3, sensorData, sensorDataBytes);
+            i += extractUint16((uint16_t *)finger->accelerometer, 3, sensorData, sensorDataBytes);
             break;
         case USB_SENSOR_TYPE_GYROSCOPE:
-            i += extractUint16((uint16_t *)fingers->finger[f].gyroscope, 3, sensorData, sensorDataBytes);
+            i += extractUint16((uint16_t *)finger->gyroscope, 3, sensorData, sensorDataBytes);
             break;
         case USB_SENSOR_TYPE_MAGNETOMETER:
-            i += extractUint16((uint16_t *)fingers->finger[f].magnetometer, 3, sensorData, sensorDataBytes);
+            i += extractUint16((uint16_t *)finger->magnetometer, 3, sensorData, sensorDataBytes);
             break;
         case USB_SENSOR_TYPE_TEMPERATURE:
-            i += extractUint16((uint16_t *)&fingers->finger[f].temperature, 1, sensorData, sensorDataBytes);
+            i += extractUint16((uint16_t *)&finger->temperature, 1, sensorData, sensorDataBytes);
             break;
         default:
              // Unknown sensor, we can't continue parsing anything from here on
@@ -168,101 +95,241 @@ static bool parseSensors(UsbPacket *packet, Fingers *fingers)
     return sawDynamic;
 }
 
-Communicator::Communicator(MainWindow *w_, const char *portName, unsigned int ms):
-    w(w_), period_ms(ms), receiveBuffer(1024)
+Communicator::Communicator(MainWindow *w_, Device *device_, SerialLink *link_, unsigned int ms):
+    w(w_), device(device_), period_ms(ms), link(link_), receiveBuffer(1024), filterChanged(true)
 {
-    port = new QSerialPort;
-
-    port->setPortName(portName);
-    port->setBaudRate(QSerialPort::Baud115200);
-    port->setDataBits(QSerialPort::Data8);
-    port->setParity(QSerialPort::NoParity);
-    port->setStopBits(QSerialPort::OneStop);
-    port->setFlowControl(QSerialPort::NoFlowControl);
+    link->moveToThread(this);
 
-    port->open(QIODevice::ReadWrite);
-
-    port->moveToThread(this);
+    for (int f = 0; f < FINGER_COUNT; ++f)
+        for (int c = 0; c < FINGER_DYNAMIC_TACTILE_COUNT; ++c)
+            contactDetectors[f][c].configure(1000.0 / ms);
+    for (int f = 0; f < FINGER_COUNT; ++f)
+        baselines[f].configure(1000.0 / ms);
 }
 
 Communicator::~Communicator()
 {
     requestInterruption();
+    link->wakeUp();
     wait();
 
-    delete port;
+    delete link;
+}
+
+bool Communicator::startRecording(const char *path)
+{
+    QMutexLocker locker(&recorderMutex);
+    return recorder.open(path, period_ms);
+}
+
+void Communicator::stopRecording()
+{
+    QMutexLocker locker(&recorderMutex);
+    recorder.close();
+}
+
+void Communicator::setFilter(const FilterSettings &settings)
+{
+    QMutexLocker locker(&filterMutex);
+    filterSettings = settings;
+    filterChanged = true;
+}
+
+void Communicator::filterBatch(std::vector<Fingers> &batch)
+{
+    const int channels = FINGER_COUNT * FINGER_DYNAMIC_TACTILE_COUNT;
+
+    // New settings take effect between batches, starting from a clean state
+    filterMutex.lock();
+    if (filterChanged)
+    {
+        filter.configure(filterSettings, 1000.0 / period_ms, channels);
+        filterChanged = false;
+    }
+    filterMutex.unlock();
+
+    // The buffer only grows up to the largest batch, so there is no allocation in the steady state
+    if (filterBuffer.size() < batch.size() * channels)
+        filterBuffer.resize(batch.size() * channels);
+
+    for (size_t i = 0; i < batch.size(); ++i)
+        for (int f = 0; f < FINGER_COUNT; ++f)
+            for (int c = 0; c < FINGER_DYNAMIC_TACTILE_COUNT; ++c)
+                filterBuffer[i * channels + f * FINGER_DYNAMIC_TACTILE_COUNT + c] = batch[i].finger[f].dynamicTactile[c];
+
+    filter.process(&filterBuffer[0], batch.size());
+
+    for (size_t i = 0; i < batch.size(); ++i)
+        for (int f = 0; f < FINGER_COUNT; ++f)
+            for (int c = 0; c < FINGER_DYNAMIC_TACTILE_COUNT; ++c)
+            {
+                double v = floor(filterBuffer[i * channels + f * FINGER_DYNAMIC_TACTILE_COUNT + c] + 0.5);
+                if (v < -32768) v = -32768;
+                if (v > 32767) v = 32767;
+                batch[i].finger[f].dynamicFiltered[c] = (int16_t)v;
+            }
+}
+
+void Communicator::detectContacts(const std::vector<Fingers> &batch)
+{
+    bool detected = false;
+
+    for (size_t i = 0; i < batch.size(); ++i)
+        for (int f = 0; f < FINGER_COUNT; ++f)
+            for (int c = 0; c < FINGER_DYNAMIC_TACTILE_COUNT; ++c)
+            {
+                ContactDetector &detector = contactDetectors[f][c];
+                ContactChange change = detector.update(batch[i].finger[f].dynamicTactile[c]);
+                if (change == CONTACT_NONE)
+                    continue;
+
+                ContactEvent event;
+                event.timestamp = batch[i].timestamp;
+                event.level = detector.level();
+                event.finger = f;
+                event.channel = c;
+                event.onset = change == CONTACT_ONSET;
+                event.latency = link->now() - batch[i].arrival;
+                device->contactEvents.push(event);
+                detected = true;
+            }
+
+    if (detected)
+        emit w->contactEventsSignal(device->id);
+}
+
+void Communicator::compensateBaseline(std::vector<Fingers> &batch)
+{
+    if (baselineResetPending.testAndSetOrdered(1, 0))
+        for (int f = 0; f < FINGER_COUNT; ++f)
+            baselines[f].reset();
+
+    for (int f = 0; f < FINGER_COUNT; ++f)
+    {
+        // A contact seen by the dynamic sensor holds the baseline too, even if the taxels barely moved yet
+        bool contact = false;
+        for (int c = 0; c < FINGER_DYNAMIC_TACTILE_COUNT; ++c)
+            contact = contact || contactDetectors[f][c].inContact();
+
+        StaticBaseline &baseline = baselines[f];
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            FingerData &d = batch[i].finger[f];
+            baseline.update(d.staticTactile, contact, d.staticCompensated);
+            d.staticNoise = (uint16_t)(baseline.noise() + 0.5);
+        }
+    }
+}
+
+void Communicator::pushSummary(const Fingers &fingers)
+{
+    int16_t values[FINGER_COUNT * SUMMARY_CHANNELS_PER_FINGER];
+
+    for (int f = 0; f < FINGER_COUNT; ++f)
+    {
+        int16_t *v = values + f * SUMMARY_CHANNELS_PER_FINGER;
+        for (int c = 0; c < FINGER_DYNAMIC_TACTILE_COUNT; ++c)
+            v[SUMMARY_DYNAMIC + c] = fingers.finger[f].dynamicTactile[c];
+        for (int a = 0; a < 3; ++a)
+        {
+            v[SUMMARY_ACCELEROMETER + a] = fingers.finger[f].accelerometer[a];
+            v[SUMMARY_GYROSCOPE + a] = fingers.finger[f].gyroscope[a];
+        }
+    }
+
+    device->summary.push(fingers.timestamp, values);
 }
 
 void Communicator::run()
 {
     UsbPacket send;
-    UsbPacket recv;
-    unsigned int recvSoFar = 0;
+    const UsbPacket *recv;
+    UsbFramer framer;
 
-    // A timer for timestamps
-    QTime timestamp;
-    timestamp.start();
+    // Estimator of when the samples were actually taken
+    SampleClock sampleClock;
+    sampleClock.reset((int64_t)period_ms * 1000000);
 
     // Timer and info used to calculate data rate
     QTime dataRate;
     dataRate.start();
     unsigned int receivedBytes = 0;
 
-    // Gathered data
+    // Gathered data, and the complete sets gathered from one read
     Fingers fingers = {0};
+    std::vector<Fingers> batch;
 
     // Send auto-send message
     send.command = USB_COMMAND_AUTOSEND_SENSORS;
     send.data_length = 1;
     send.data[0] = period_ms;
-    usbSend(port, &send);
+    usbSend(link, &send);
 
     while (!isInterruptionRequested())
     {
-        // Call waitForReadyRead to process messages (remember, this thread doesn't have a QT event loop)
-        port->waitForReadyRead(1);
-
-        int64_t available = port->bytesAvailable();
-        if (available <= 0)
+        int64_t available = link->read(receiveBuffer);
+        int64_t arrival = link->readTime();
+        if (available < 0)
+        {
+            emit w->closeConnectionSignal(device->id);
+            break;
+        }
+        if (available == 0)
             continue;
 
-        // Make sure there is enough room in the buffer
-        if (receiveBuffer.size() < available)
-            receiveBuffer.resize(available);
-
-        available = port->read(receiveBuffer.data(), available);
+        recorderMutex.lock();
+        if (recorder.isOpen())
+            recorder.record(arrival, receiveBuffer.data(), available);
+        recorderMutex.unlock();
 
         // Show progress
         receivedBytes += available;
         if (dataRate.elapsed() > 200)
         {
             int elapsed = dataRate.restart();
-            emit w->updateConnectionDataRateSignal((uint64_t)receivedBytes * 1000 / elapsed);
+            emit w->updateConnectionDataRateSignal(device->id, (uint64_t)receivedBytes * 1000 / elapsed);
+            emit w->updateConnectionLinkStatsSignal(device->id, framer.stats());
+            emit w->updateConnectionClockSignal(device->id, sampleClock.stats());
             receivedBytes = 0;
         }
 
         // Parse packets and store sensor values
-        for (int64_t i = 0; i < available; ++i)
+        framer.feed((const uint8_t *)receiveBuffer.data(), available);
+        while ((recv = framer.next()) != NULL)
         {
-            if (usbReadByte(&recv, &recvSoFar, receiveBuffer[i]))
+            bool newSetOfData = parseSensors(recv, &fingers);
+
+            // Many messages can arrive in the same millisecond, so let the data accumulate and store it only when a whole set is complete
+            if (newSetOfData)
             {
-                bool newSetOfData = parseSensors(&recv, &fingers);
-
-                // Many messages can arrive in the same millisecond, so let the data accumulate and store it only when a whole set is complete
-                if (newSetOfData)
-                {
-                    fingers.timestamp = timestamp.elapsed();
-                    emit w->newFingerDataSignal(fingers);
-                }
+                fingers.arrival = arrival;
+                fingers.timestamp = sampleClock.update(arrival);
+                batch.push_back(fingers);
             }
         }
+
+        // Look for contacts first, since they are time critical.  Then filter and store the whole batch at once, and
+        // tell the GUI about it unless a notification is already on its way.
+        if (!batch.empty())
+        {
+            detectContacts(batch);
+            compensateBaseline(batch);
+            filterBatch(batch);
+            device->fingerData.push(batch);
+            for (size_t i = 0; i < batch.size(); ++i)
+                pushSummary(batch[i]);
+            batch.clear();
+
+            if (device->notifyPending.testAndSetOrdered(0, 1))
+                emit w->newFingerDataSignal(device->id, device->fingerData.sequence());
+        }
     }
 
     // Stop auto-send message
     send.command = USB_COMMAND_AUTOSEND_SENSORS;
     send.data_length = 1;
     send.data[0] = 0;
-    usbSend(port, &send);
+    usbSend(link, &send);
 
-    port->moveToThread(QApplication::instance()->thread());
+    link->moveToThread(QApplication::instance()->thread());
 }
@@ -22,24 +22,69 @@
 #include "mainwindow.h"
 #include "circular_buffer.h"
 #include "finger_data.h"
+#include "usb_framer.h"
+#include "serial_link.h"
+#include "sample_clock.h"
+#include "replay.h"
+#include "filter.h"
+#include "contact_detector.h"
+#include "static_baseline.h"
 #include <QThread>
-#include <QSerialPort>
+#include <QMutex>
 
 class Communicator: public QThread
 {
 public:
-    Communicator(MainWindow *w_, const char *portName, unsigned int ms);
+    // Note: the communicator takes ownership of the link
+    Communicator(MainWindow *w_, struct Device *device_, SerialLink *link_, unsigned int ms);
     ~Communicator();
 
-    QSerialPort::SerialPortError portError() { return port->error(); }
+    QSerialPort::SerialPortError portError() { return link->error(); }
     void run();
 
+    // Record the raw data received from the port, to be replayed later
+    bool startRecording(const char *path);
+    void stopRecording();
+
+    // Filter the dynamic channels with these settings from the next batch on
+    void setFilter(const FilterSettings &settings);
+
+    // Start the baselines of the static sensors over from the next sample
+    void resetBaseline() { baselineResetPending.store(1); }
+
 private:
+    // Add a sample to the long term history of the device
+    void pushSummary(const Fingers &fingers);
+
+    // Fill in the filtered dynamic channels of a batch
+    void filterBatch(std::vector<Fingers> &batch);
+
+    // Look for contact changes in a batch
+    void detectContacts(const std::vector<Fingers> &batch);
+
+    // Fill in the drift compensated static channels of a batch
+    void compensateBaseline(std::vector<Fingers> &batch);
+
     MainWindow *w;
+    struct Device *device;
     unsigned int period_ms;
-    QSerialPort *port;
+    SerialLink *link;
 
     std::vector<char> receiveBuffer;
+
+    QMutex recorderMutex;
+    RawRecorder recorder;
+
+    QMutex filterMutex;
+    FilterSettings filterSettings;
+    bool filterChanged;
+    FilterChain filter;                 // only used by the acquisition thread
+    std::vector<double> filterBuffer;   // the dynamic channels of a batch, interleaved
+
+    ContactDetector contactDetectors[FINGER_COUNT][FINGER_DYNAMIC_TACTILE_COUNT];
+
+    StaticBaseline baselines[FINGER_COUNT];
+    QAtomicInt baselineResetPending;
 };
 
 #endif // COMMUNICATOR_H
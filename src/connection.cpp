@@ -19,7 +19,10 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "communicator.h"
-#include <QSerialPortInfo>
+#include "device.h"
+#include "port_scanner.h"
+#include <QFileDialog>
+#include <algorithm>
 
 void MainWindow::refreshPorts()
 {
@@ -28,53 +31,128 @@ void MainWindow::refreshPorts()
 
 void MainWindow::refreshPortsAutoconnect(bool allowAutoconnect)
 {
+    // The ports are listed on another thread.  If that is already in progress, list them again once it's done, since
+    // the ports may have changed in the mean time.
+    if (portScanRunning)
+    {
+        portScanPending = true;
+        portScanAutoconnect = portScanAutoconnect || allowAutoconnect;
+        return;
+    }
+
+    portScanRunning = true;
+    portScanner->scan(allowAutoconnect);
+}
+
+void MainWindow::portsFound(QStringList ports, QStringList descriptions, bool allowAutoconnect)
+{
+    portScanRunning = false;
+    if (portScanPending)
+    {
+        // Skip the outdated result, but not its request to autoconnect
+        bool autoconnect = portScanAutoconnect || allowAutoconnect;
+        portScanPending = false;
+        portScanAutoconnect = false;
+        refreshPortsAutoconnect(autoconnect);
+        return;
+    }
+
     int index = 0;
     ui->availablePorts->clear();
-    bool foundFinger = false;
-    foreach (const QSerialPortInfo &info, QSerialPortInfo::availablePorts())
+    QStringList fingerPorts;
+    for (int i = 0; i < ports.size(); ++i)
     {
-        QString desc = info.description();
+        QString desc = descriptions[i];
         if (desc.length() >= 20)
             desc = desc.left(17) + "...";
-        ui->availablePorts->addItem(info.portName() + " (" + desc + ")");
+        ui->availablePorts->addItem(ports[i] + " (" + desc + ")");
 
         // Note: for some strange reason, on windows the description is not the updated CoRo Tactile Sensor
-        if (info.description() == "CoRo Tactile Sensor" || info.description() == "Cypress USB UART")
+        if (descriptions[i] == "CoRo Tactile Sensor" || descriptions[i] == "Cypress USB UART")
         {
             ui->availablePorts->setCurrentIndex(index);
-            foundFinger = true;
+            fingerPorts.append(ports[i]);
         }
 
         ++index;
     }
 
-    if (foundFinger && ui->autoconnect->isChecked() && allowAutoconnect)
-        openConnection();
+    updateConnectButton();
+
+    // Connect to every sensor board that is not already connected
+    if (ui->autoconnect->isChecked() && allowAutoconnect)
+        foreach (const QString &port, fingerPorts)
+            if (findDevice(port) == NULL)
+                openConnection(port);
+}
+
+QString MainWindow::selectedPort()
+{
+    QString port = ui->availablePorts->currentText();
+    return port.left(port.indexOf(' '));
+}
+
+void MainWindow::updateConnectButton()
+{
+    ui->connect->setText(findDevice(selectedPort())?"Disconnect":"Connect");
 }
 
 void MainWindow::openCloseConnection()
 {
-    if (communicator)
-        closeConnection();
+    QString port = selectedPort();
+    Device *device = findDevice(port);
+
+    if (device)
+    {
+        closeDevice(device);
+        refreshPortsAutoconnect(false);
+    }
     else
-        openConnection();
+        openConnection(port);
 }
 
-void MainWindow::openConnection()
+void MainWindow::openConnection(const QString &port)
 {
-    if (ui->availablePorts->count() < 0)
+    if (port.isEmpty())
     {
         connectionFailed("No serial ports detected");
         return;
     }
 
-    QString port = ui->availablePorts->currentText();
-    port = port.left(port.indexOf(' '));
+    SerialBackend backend = ui->nativeSerial->isChecked()?SERIAL_BACKEND_POSIX:SERIAL_BACKEND_QT;
+    openDevice(port, SerialLink::open(backend, port.toUtf8().data()), ui->samplePeriod->currentData().toUInt());
+}
+
+void MainWindow::selectReplayFile()
+{
+    QString path = QFileDialog::getOpenFileName(this, tr("Select a recording to replay:"), QDir::homePath(),
+                                                "Recordings (*.raw *.csv);;All files (*)");
+    if (path.isEmpty())
+        return;
+
+    replay(path, ui->replaySpeed->currentData().toDouble());
+}
 
-    communicator = new Communicator(this, port.toUtf8().data(), READ_DATA_PERIOD_MS);
-    if (communicator->portError())
+void MainWindow::replay(const QString &path, double speed)
+{
+    ReplayLink *link = new ReplayLink(path.toUtf8().data(), speed);
+
+    // The timestamps of the replayed data follow the period it was recorded with, not the one currently selected.  Old
+    // raw recordings don't say, in which case the selection is the best guess.
+    unsigned int periodMs = link->periodMs();
+    if (periodMs == 0)
+        periodMs = ui->samplePeriod->currentData().toUInt();
+
+    openDevice(path, link, periodMs);
+}
+
+void MainWindow::openDevice(const QString &port, SerialLink *link, unsigned int periodMs)
+{
+    Device *device = new Device(nextDeviceId++, port, periodMs, ui->historyWindow->currentData().toUInt());
+    device->communicator = new Communicator(this, device, link, device->periodMs);
+    if (device->communicator->portError())
     {
-        switch (communicator->portError())
+        switch (device->communicator->portError())
         {
         case QSerialPort::PermissionError:
             connectionFailed("Insufficient permission to open port");
@@ -86,31 +164,132 @@ void MainWindow::openConnection()
             connectionFailed("Could not open port");
             break;
         }
-        delete communicator;
-        communicator = NULL;
+        delete device->communicator;
+        delete device;
         return;
     }
 
-    connectionOpened(port.toUtf8().data());
-    communicator->start();
+    device->communicator->setFilter(filterSettings());
+
+    devicesMutex.lock();
+    devices.push_back(device);
+    devicesMutex.unlock();
+    ui->shownDevice->addItem(port, device->id);
+
+    if (logging)
+        startDeviceLog(device);
+
+    connectionOpened();
+    device->communicator->start();
 }
 
-void MainWindow::closeConnection()
+void MainWindow::closeDevice(Device *device)
 {
-    delete communicator;
-    communicator = false;
+    // Stop the acquisition thread first, so nothing touches the device afterwards
+    delete device->communicator;
+    device->communicator = NULL;
+    stopDeviceLog(device);
 
-    connectionClosed("Not connected");
-    refreshPortsAutoconnect(false);
+    // Wait for the renderer to be done with the device
+    devicesMutex.lock();
+    devices.erase(std::find(devices.begin(), devices.end(), device));
+    devicesMutex.unlock();
+    ui->shownDevice->removeItem(ui->shownDevice->findData(device->id));
+    delete device;
+
+    if (devices.empty())
+        connectionClosed("Not connected");
+    else
+        updateConnectionStatus();
+}
+
+void MainWindow::closeConnection(int device)
+{
+    Device *d = findDevice(device);
+    if (d == NULL)
+        return;
+
+    // A replay that reaches the end of the recording stops without an error
+    bool lost = d->communicator->portError() != QSerialPort::NoError;
+
+    closeDevice(d);
+    connectionFailed(lost?"Connection lost":"Replay finished");
+}
+
+Device *MainWindow::findDevice(int id)
+{
+    for (size_t i = 0; i < devices.size(); ++i)
+        if (devices[i]->id == id)
+            return devices[i];
+    return NULL;
+}
+
+Device *MainWindow::findDevice(const QString &port)
+{
+    for (size_t i = 0; i < devices.size(); ++i)
+        if (devices[i]->port == port)
+            return devices[i];
+    return NULL;
+}
+
+Device *MainWindow::shownDevice()
+{
+    if (ui->shownDevice->currentIndex() < 0)
+        return NULL;
+    return findDevice(ui->shownDevice->currentData().toInt());
+}
+
+void MainWindow::showDevice()
+{
+    // The zoom of the static graphs belongs to the previously shown board, while the baselines are kept per board
+    pendingBaselineReset = true;
+    updateConnectionStatus();
+    updateContactStatus();
+}
+
+void MainWindow::updateContactStatus()
+{
+    Device *device = shownDevice();
+    if (device == NULL)
+    {
+        ui->contactStatus->setText("");
+        return;
+    }
+
+    QString status;
+    for (int f = 0; f < FINGER_COUNT; ++f)
+        status += QString("Sensor %1: %2    ").arg(f + 1).arg(device->contact[f]?"Contact":"Free");
+    status += QString("Detection latency: %1 ms (max %2 ms)")
+              .arg(device->contactLatencyLast / 1e6, 0, 'f', 3)
+              .arg(device->contactLatencyMax / 1e6, 0, 'f', 3);
+    ui->contactStatus->setText(status);
+}
+
+FilterSettings MainWindow::filterSettings()
+{
+    FilterSettings settings;
+    settings.highpass = ui->filterHighpass->currentData().toDouble();
+    settings.notch = ui->filterNotch->currentData().toDouble();
+    settings.lowpass = ui->filterLowpass->currentData().toDouble();
+    settings.lowpassFIR = ui->filterLowpassType->currentIndex() == 1;
+    return settings;
+}
+
+void MainWindow::changeFilter()
+{
+    // Every board filters its own data, on its acquisition thread
+    FilterSettings settings = filterSettings();
+    for (size_t d = 0; d < devices.size(); ++d)
+        devices[d]->communicator->setFilter(settings);
 }
 
 void MainWindow::connectionFailed(const char *status)
 {
-    connectionClosed(status);
+    if (devices.empty())
+        connectionClosed(status);
+    else
+        ui->connectionStatus->setText(status);
     refreshPortsAutoconnect(false);
-
-    stopLog();
-    ui->log->setEnabled(false);
 }
 
 void MainWindow::connectionClosed(const char *status)
@@ -118,37 +297,110 @@ void MainWindow::connectionClosed(const char *status)
     ui->connectionStatus->setText(status);
     ui->connectionDataRate->hide();
     ui->connectionStatusSeparator->hide();
+    ui->connectionLinkStats->hide();
+    ui->connectionLinkStatsSeparator->hide();
+    ui->connectionClock->hide();
+    ui->connectionClockSeparator->hide();
+    ui->shownDevice->hide();
+    ui->shownDeviceSeparator->hide();
 
     for (int i = 1; i < ui->alltabs->count(); ++ i)
         ui->alltabs->setTabEnabled(i, false);
 
-    ui->connect->setText("Connect");
-
-    fingerData.clear();
+    updateConnectButton();
 
     stopLog();
     ui->log->setEnabled(false);
 }
 
-void MainWindow::connectionOpened(const char *status)
+void MainWindow::connectionOpened()
 {
-    ui->connectionStatus->setText(status);
-    ui->connectionDataRate->setText("0 KB/s");
+    bool firstDevice = devices.size() == 1;
+
+    updateConnectionStatus();
     ui->connectionDataRate->show();
     ui->connectionStatusSeparator->show();
+    ui->connectionLinkStats->show();
+    ui->connectionLinkStatsSeparator->show();
+    ui->connectionClock->show();
+    ui->connectionClockSeparator->show();
 
     for (int i = 1; i < ui->alltabs->count(); ++ i)
         ui->alltabs->setTabEnabled(i, true);
 
-    ui->connect->setText("Disconnect");
+    updateConnectButton();
 
     // switch to static data
-    ui->alltabs->setCurrentIndex(1);
+    if (firstDevice)
+        ui->alltabs->setCurrentIndex(1);
 
     ui->log->setEnabled(true);
 }
 
-void MainWindow::updateConnectionDataRate(unsigned int bs)
+void MainWindow::updateConnectionStatus()
 {
+    QStringList ports;
+    for (size_t i = 0; i < devices.size(); ++i)
+        ports.append(devices[i]->port);
+    ui->connectionStatus->setText(ports.join(", "));
+
+    // Only show the device selection if there is a choice
+    ui->shownDevice->setVisible(devices.size() > 1);
+    ui->shownDeviceSeparator->setVisible(devices.size() > 1);
+
+    Device *d = shownDevice();
+    updateConnectionDataRate(d?d->id:-1, d?d->dataRate:0);
+    if (d)
+    {
+        updateConnectionLinkStats(d->id, d->linkStats);
+        updateConnectionClock(d->id, d->clockStats);
+    }
+    else
+    {
+        ui->connectionLinkStats->setText("");
+        ui->connectionClock->setText("");
+    }
+}
+
+void MainWindow::updateConnectionDataRate(int device, unsigned int bs)
+{
+    Device *d = findDevice(device);
+    if (d)
+        d->dataRate = bs;
+    if (d != shownDevice())
+        return;
+
     ui->connectionDataRate->setText(QString().asprintf("%u.%03u KB/s", bs / 1000, bs % 1000));
 }
+
+void MainWindow::updateConnectionLinkStats(int device, UsbLinkStats stats)
+{
+    Device *d = findDevice(device);
+    if (d == NULL)
+        return;
+    d->linkStats = stats;
+    if (d != shownDevice())
+        return;
+
+    ui->connectionLinkStats->setText(QString().asprintf("%llu packets, %llu CRC errors, %llu resyncs, %llu bytes dropped",
+                                                        (unsigned long long)stats.goodFrames,
+                                                        (unsigned long long)stats.crcFailures,
+                                                        (unsigned long long)stats.resyncs,
+                                                        (unsigned long long)stats.discardedBytes) +
+                                     (d->logReader.overruns()?
+                                      QString().asprintf(", %llu samples not logged",
+                                                         (unsigned long long)d->logReader.overruns()):QString()));
+}
+
+void MainWindow::updateConnectionClock(int device, SampleClockStats stats)
+{
+    Device *d = findDevice(device);
+    if (d == NULL)
+        return;
+    d->clockStats = stats;
+    if (d != shownDevice())
+        return;
+
+    ui->connectionClock->setText(QString().asprintf("Period %.4f ms, jitter %.0f us, drift %+.0f ppm",
+                                                    stats.period / 1e6, stats.jitter / 1e3, stats.drift));
+}
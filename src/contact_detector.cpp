@@ -0,0 +1,112 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "contact_detector.h"
+#include <math.h>
+
+#define HIGHPASS_HZ 20
+#define ATTACK_S 0.001
+#define RELEASE_S 0.02
+#define NOISE_S 2.0
+#define WARMUP_S 0.5
+#define HOLD_S 0.05
+
+// Thresholds relative to the noise floor, which itself is at least a few ADC counts
+#define ONSET_RATIO 6
+#define OFFSET_RATIO 2
+#define MIN_NOISE 2
+
+// Coefficient of a first order smoother with time constant tau
+static double smoothing(double tau, double sampleRate)
+{
+    return 1 - exp(-1 / (tau * sampleRate));
+}
+
+ContactDetector::ContactDetector()
+{
+    configure(1000);
+}
+
+void ContactDetector::configure(double sampleRate)
+{
+    // Without room for the highpass, the signal is used as is
+    if (HIGHPASS_HZ < sampleRate / 2)
+        highpass = Biquad::highpass(HIGHPASS_HZ, sampleRate, M_SQRT1_2);
+    else
+    {
+        Biquad pass = {1, 0, 0, 0, 0};
+        highpass = pass;
+    }
+
+    attack = smoothing(ATTACK_S, sampleRate);
+    release = smoothing(RELEASE_S, sampleRate);
+    noiseRate = smoothing(NOISE_S, sampleRate);
+    warmupRate = smoothing(WARMUP_S / 4, sampleRate);
+    warmup = (unsigned int)(WARMUP_S * sampleRate);
+    hold = (unsigned int)(HOLD_S * sampleRate) + 1;
+
+    z1 = z2 = 0;
+    envelope = 0;
+    noise = MIN_NOISE;
+    contact = false;
+    samples = 0;
+    quiet = 0;
+}
+
+ContactChange ContactDetector::update(int16_t sample)
+{
+    double x = sample;
+    double y = highpass.b0 * x + z1;
+    z1 = highpass.b1 * x - highpass.a1 * y + z2;
+    z2 = highpass.b2 * x - highpass.a2 * y;
+
+    double magnitude = fabs(y);
+    envelope += (magnitude - envelope) * (magnitude > envelope?attack:release);
+
+    // Until the highpass and the noise floor have settled, only learn
+    if (samples < warmup)
+    {
+        ++samples;
+        noise += (envelope - noise) * warmupRate;
+        if (noise < MIN_NOISE)
+            noise = MIN_NOISE;
+        return CONTACT_NONE;
+    }
+
+    if (!contact)
+    {
+        if (envelope > ONSET_RATIO * noise)
+        {
+            contact = true;
+            quiet = 0;
+            return CONTACT_ONSET;
+        }
+
+        noise += (envelope - noise) * noiseRate;
+        if (noise < MIN_NOISE)
+            noise = MIN_NOISE;
+        return CONTACT_NONE;
+    }
+
+    quiet = envelope < OFFSET_RATIO * noise?quiet + 1:0;
+    if (quiet < hold)
+        return CONTACT_NONE;
+
+    contact = false;
+    return CONTACT_OFFSET;
+}
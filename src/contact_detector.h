@@ -0,0 +1,78 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONTACT_DETECTOR_H
+#define CONTACT_DETECTOR_H
+
+#include <stdint.h>
+#include "filter.h"
+
+// A change of contact on a dynamic channel
+struct ContactEvent
+{
+    int64_t timestamp;      // time of the sample that triggered the event, like Fingers::timestamp
+    int64_t latency;        // ns from reading the sample off the port until the event was queued
+    float level;            // envelope of the signal, relative to its noise floor
+    uint8_t finger;
+    uint8_t channel;
+    bool onset;             // contact or slip started, otherwise it ended
+};
+
+enum ContactChange
+{
+    CONTACT_NONE,
+    CONTACT_ONSET,
+    CONTACT_OFFSET,
+};
+
+/*
+ * Detection of contact and slip transients on one dynamic channel, one sample at a time.  The signal is highpassed
+ * (so that the offset and slow drift don't matter), and its envelope (fast attack, slow release) is compared to a
+ * running estimate of the noise floor with hysteresis: an onset when the envelope rises well above the noise, and an
+ * offset once it has stayed close to the noise for a while.  The noise floor is only tracked outside of contacts.
+ *
+ * All the state is a handful of doubles, so the cost is constant per sample, with no allocation.
+ */
+class ContactDetector
+{
+public:
+    ContactDetector();
+
+    // Set up for a sample rate.  Clears the state.
+    void configure(double sampleRate);
+
+    ContactChange update(int16_t sample);
+
+    bool inContact() const { return contact; }
+    double level() const { return envelope / noise; }
+
+private:
+    Biquad highpass;
+    double z1, z2;
+
+    double attack, release, noiseRate, warmupRate;
+    unsigned int warmup, hold;
+
+    double envelope;
+    double noise;
+    bool contact;
+    unsigned int samples;       // samples seen, up to warmup
+    unsigned int quiet;         // samples in a row below the offset threshold
+};
+
+#endif // CONTACT_DETECTOR_H
@@ -0,0 +1,195 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "decimate.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DECIMATE_SSE2 1
+#endif
+
+// Minimum and maximum of y[0..n), n > 0
+static inline void bucketMinMax(const double *y, size_t n, double &min, double &max)
+{
+    size_t i;
+
+#ifdef DECIMATE_SSE2
+    if (n >= 4)
+    {
+        // Two independent pairs of accumulators hide the latency of min/max
+        __m128d min0 = _mm_loadu_pd(y), max0 = min0;
+        __m128d min1 = _mm_loadu_pd(y + 2), max1 = min1;
+        for (i = 4; i + 4 <= n; i += 4)
+        {
+            __m128d v0 = _mm_loadu_pd(y + i);
+            __m128d v1 = _mm_loadu_pd(y + i + 2);
+            min0 = _mm_min_pd(min0, v0);
+            max0 = _mm_max_pd(max0, v0);
+            min1 = _mm_min_pd(min1, v1);
+            max1 = _mm_max_pd(max1, v1);
+        }
+        min0 = _mm_min_pd(min0, min1);
+        max0 = _mm_max_pd(max0, max1);
+
+        double mins[2], maxs[2];
+        _mm_storeu_pd(mins, min0);
+        _mm_storeu_pd(maxs, max0);
+        min = mins[0] < mins[1]?mins[0]:mins[1];
+        max = maxs[0] > maxs[1]?maxs[0]:maxs[1];
+    }
+    else
+#endif
+    {
+        min = max = y[0];
+        i = 1;
+    }
+
+    for (; i < n; ++i)
+    {
+        if (y[i] < min) min = y[i];
+        if (y[i] > max) max = y[i];
+    }
+}
+
+static inline size_t find(const double *y, size_t n, double value)
+{
+    size_t i = 0;
+    while (i < n - 1 && y[i] != value)
+        ++i;
+    return i;
+}
+
+size_t decimateMinMax(const double *x, const double *y, size_t n, size_t buckets, double *outX, double *outY)
+{
+    if (n <= 2 * buckets)
+    {
+        memcpy(outX, x, n * sizeof *x);
+        memcpy(outY, y, n * sizeof *y);
+        return n;
+    }
+
+    size_t count = 0;
+    for (size_t b = 0; b < buckets; ++b)
+    {
+        size_t start = b * n / buckets;
+        size_t end = (b + 1) * n / buckets;
+        double min, max;
+
+        bucketMinMax(y + start, end - start, min, max);
+
+        // Output the two extremes in the order they appear, so the line goes through them as the data did
+        size_t iMin = start + find(y + start, end - start, min);
+        size_t iMax = start + find(y + start, end - start, max);
+        size_t first = iMin < iMax?iMin:iMax;
+        size_t second = iMin < iMax?iMax:iMin;
+
+        outX[count] = x[first];
+        outY[count] = y[first];
+        ++count;
+        if (second != first)
+        {
+            outX[count] = x[second];
+            outY[count] = y[second];
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+size_t decimateLttb(const double *x, const double *y, size_t n, size_t points, double *outX, double *outY)
+{
+    if (n <= points || points < 3)
+    {
+        if (n > points)
+            n = points;
+        memcpy(outX, x, n * sizeof *x);
+        memcpy(outY, y, n * sizeof *y);
+        return n;
+    }
+
+    // The first and last points are always kept, and the rest is divided in points - 2 buckets
+    size_t buckets = points - 2;
+    size_t count = 0;
+    size_t selected = 0;
+
+    outX[count] = x[0];
+    outY[count] = y[0];
+    ++count;
+
+    for (size_t b = 0; b < buckets; ++b)
+    {
+        size_t start = 1 + b * (n - 2) / buckets;
+        size_t end = 1 + (b + 1) * (n - 2) / buckets;
+
+        // Average of the next bucket (or the last point for the last bucket)
+        size_t nextStart = end;
+        size_t nextEnd = b + 1 < buckets?1 + (b + 2) * (n - 2) / buckets:n;
+        double avgX = 0, avgY = 0;
+        for (size_t i = nextStart; i < nextEnd; ++i)
+        {
+            avgX += x[i];
+            avgY += y[i];
+        }
+        avgX /= nextEnd - nextStart;
+        avgY /= nextEnd - nextStart;
+
+        // Choose the point of this bucket that makes the largest triangle with the previously selected point and
+        // the average of the next bucket
+        double ax = x[selected], ay = y[selected];
+        double maxArea = -1;
+        size_t best = start;
+        for (size_t i = start; i < end; ++i)
+        {
+            double area = (ax - avgX) * (y[i] - ay) - (ax - x[i]) * (avgY - ay);
+            if (area < 0)
+                area = -area;
+            if (area > maxArea)
+            {
+                maxArea = area;
+                best = i;
+            }
+        }
+
+        outX[count] = x[best];
+        outY[count] = y[best];
+        ++count;
+        selected = best;
+    }
+
+    outX[count] = x[n - 1];
+    outY[count] = y[n - 1];
+    ++count;
+
+    return count;
+}
+
+size_t decimate(DecimationMethod method, const double *x, const double *y, size_t n, size_t width,
+                double *outX, double *outY)
+{
+    switch (method)
+    {
+    case DECIMATION_LTTB:
+        return decimateLttb(x, y, n, 2 * width, outX, outY);
+    case DECIMATION_MIN_MAX:
+    default:
+        // DECIMATION_NONE is not expected here, since there is nothing to reduce
+        return decimateMinMax(x, y, n, width, outX, outY);
+    }
+}
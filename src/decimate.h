@@ -0,0 +1,54 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DECIMATE_H
+#define DECIMATE_H
+
+#include <stddef.h>
+
+/*
+ * Reduction of a series to about as many points as the graph has pixels, so the cost of plotting doesn't depend on the
+ * sample rate or the length of the window.
+ *
+ * Min/max keeps the minimum and maximum of every bucket in the order they occur, so a transient as short as one
+ * sample is still drawn.  LTTB (Largest-Triangle-Three-Buckets) keeps one point per bucket, chosen to preserve the
+ * visual shape of the series; it looks smoother but may lose isolated peaks.
+ */
+enum DecimationMethod
+{
+    DECIMATION_NONE,
+    DECIMATION_MIN_MAX,
+    DECIMATION_LTTB,
+};
+
+// Reduce (x, y) to at most 2 * buckets points in (outX, outY).  Returns the number of points.
+size_t decimateMinMax(const double *x, const double *y, size_t n, size_t buckets, double *outX, double *outY);
+
+// Reduce (x, y) to at most points points in (outX, outY).  Returns the number of points.
+size_t decimateLttb(const double *x, const double *y, size_t n, size_t points, double *outX, double *outY);
+
+/*
+ * Reduce (x, y) for a graph that is width pixels wide, using the given method.  The outputs must have room for
+ * 2 * width points.  If there is little enough data, the series is copied as is.  Returns the number of points.
+ *
+ * With DECIMATION_NONE, the caller plots the whole series directly instead.
+ */
+size_t decimate(DecimationMethod method, const double *x, const double *y, size_t n, size_t width,
+                double *outX, double *outY);
+
+#endif // DECIMATE_H
@@ -0,0 +1,111 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DEVICE_H
+#define DEVICE_H
+
+#include <QString>
+#include <QAtomicInt>
+#include <stdio.h>
+#include <string.h>
+#include "finger_history.h"
+#include "history_pyramid.h"
+#include "usb_framer.h"
+#include "sample_clock.h"
+#include "contact_detector.h"
+
+// Channels of every finger that are kept in the long term history
+enum SummaryChannel
+{
+    SUMMARY_DYNAMIC = 0,
+    SUMMARY_ACCELEROMETER = SUMMARY_DYNAMIC + FINGER_DYNAMIC_TACTILE_COUNT,
+    SUMMARY_GYROSCOPE = SUMMARY_ACCELEROMETER + 3,
+    SUMMARY_CHANNELS_PER_FINGER = SUMMARY_GYROSCOPE + 3,
+};
+
+/*
+ * A connected sensor board.  Every board has its own acquisition thread (and therefore its own parser state) and its
+ * own data buffers, so boards don't slow each other down.  Devices are identified by an id that is never reused, so
+ * that queued signals from a board that is already disconnected can be recognized and ignored.
+ */
+struct Device
+{
+    Device(int id_, const QString &port_, unsigned int periodMs_, unsigned int historySeconds):
+        id(id_),
+        port(port_),
+        periodMs(periodMs_),
+        historySamples(historySeconds * 1000 / periodMs_),
+        communicator(NULL),
+        fingerData(historySamples + 1000 / periodMs_),      // extra second so readers aren't overrun
+        plotReader(fingerData),
+        logReader(fingerData),
+        summary(FINGER_COUNT * SUMMARY_CHANNELS_PER_FINGER),
+        logFile(NULL),
+        contactEvents(1024),
+        contactReader(contactEvents),
+        contactLatencyLast(0),
+        contactLatencyMax(0),
+        notifyPending(0),
+        dataSequence(0),
+        dataRate(0)
+    {
+        memset(&linkStats, 0, sizeof linkStats);
+        memset(&clockStats, 0, sizeof clockStats);
+        memset(contact, 0, sizeof contact);
+    }
+
+    int id;
+    QString port;
+
+    // Acquisition settings, chosen at connect time
+    unsigned int periodMs;
+    unsigned int historySamples;
+
+    class Communicator *communicator;
+
+    // History of the data, written directly by the acquisition thread one batch per read.  The plots look at it
+    // without consuming, while the logger consumes it.
+    FingerHistory fingerData;
+    FingerHistory::Reader plotReader, logReader;
+
+    // Min/max/mean of the dynamic and IMU channels going back hours, for zooming out
+    HistoryPyramid summary;
+    FILE *logFile;
+
+    // Contact and slip events, queued by the acquisition thread as soon as they are detected.  Other consumers (e.g. a
+    // controller) can read the queue with their own reader.
+    SpmcRing<ContactEvent> contactEvents;
+    SpmcRing<ContactEvent>::Reader contactReader;     // the GUI's
+
+    // What the GUI made of the events: whether each finger is in contact, and how long detection took
+    bool contact[FINGER_COUNT];
+    int64_t contactLatencyLast, contactLatencyMax;
+
+    // Set by the acquisition thread when it notifies the GUI of new data, and cleared by the GUI once per frame, so
+    // that at most one notification is queued no matter how slowly the GUI runs
+    QAtomicInt notifyPending;
+    // The fingerData sequence up to which the GUI was notified
+    uint64_t dataSequence;
+
+    // Last reported state of the link
+    unsigned int dataRate;
+    UsbLinkStats linkStats;
+    SampleClockStats clockStats;
+};
+
+#endif // DEVICE_H
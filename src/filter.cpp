@@ -0,0 +1,225 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "filter.h"
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FILTER_SSE2 1
+#endif
+
+#define NOTCH_Q 30
+#define FIR_TAPS 63
+
+static Biquad normalize(double b0, double b1, double b2, double a0, double a1, double a2)
+{
+    Biquad q = {b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0};
+    return q;
+}
+
+Biquad Biquad::lowpass(double f, double sampleRate, double q)
+{
+    double w = 2 * M_PI * f / sampleRate;
+    double alpha = sin(w) / (2 * q);
+    double c = cos(w);
+    return normalize((1 - c) / 2, 1 - c, (1 - c) / 2, 1 + alpha, -2 * c, 1 - alpha);
+}
+
+Biquad Biquad::highpass(double f, double sampleRate, double q)
+{
+    double w = 2 * M_PI * f / sampleRate;
+    double alpha = sin(w) / (2 * q);
+    double c = cos(w);
+    return normalize((1 + c) / 2, -(1 + c), (1 + c) / 2, 1 + alpha, -2 * c, 1 - alpha);
+}
+
+Biquad Biquad::notch(double f, double sampleRate, double q)
+{
+    double w = 2 * M_PI * f / sampleRate;
+    double alpha = sin(w) / (2 * q);
+    double c = cos(w);
+    return normalize(1, -2 * c, 1, 1 + alpha, -2 * c, 1 - alpha);
+}
+
+FilterChain::FilterChain():
+    channelCount(0),
+    primed(false),
+    firPosition(0)
+{
+}
+
+void FilterChain::configure(const FilterSettings &settings, double sampleRate, int channels)
+{
+    // The quality factors of the two sections of a 4th order Butterworth filter
+    static const double butterworth[2] = {0.54119610, 1.30656296};
+    double nyquist = sampleRate / 2;
+
+    channelCount = channels;
+    sections.clear();
+    fir.clear();
+
+    if (settings.highpass > 0 && settings.highpass < nyquist)
+        for (int i = 0; i < 2; ++i)
+            sections.push_back(Biquad::highpass(settings.highpass, sampleRate, butterworth[i]));
+    if (settings.notch > 0 && settings.notch < nyquist)
+        sections.push_back(Biquad::notch(settings.notch, sampleRate, NOTCH_Q));
+    if (settings.lowpass > 0 && settings.lowpass < nyquist)
+    {
+        if (!settings.lowpassFIR)
+            for (int i = 0; i < 2; ++i)
+                sections.push_back(Biquad::lowpass(settings.lowpass, sampleRate, butterworth[i]));
+        else
+        {
+            // Hamming windowed sinc, with unit gain at DC
+            double fc = settings.lowpass / sampleRate;
+            double sum = 0;
+            fir.resize(FIR_TAPS);
+            for (int k = 0; k < FIR_TAPS; ++k)
+            {
+                double n = k - (FIR_TAPS - 1) / 2.0;
+                double sinc = n == 0?2 * fc:sin(2 * M_PI * fc * n) / (M_PI * n);
+                fir[k] = sinc * (0.54 - 0.46 * cos(2 * M_PI * k / (FIR_TAPS - 1)));
+                sum += fir[k];
+            }
+            for (int k = 0; k < FIR_TAPS; ++k)
+                fir[k] /= sum;
+        }
+    }
+
+    state.resize(sections.size() * 2 * channels);
+    firLines.resize(fir.size() * 2 * channels);
+    reset();
+}
+
+void FilterChain::reset()
+{
+    for (size_t i = 0; i < state.size(); ++i)
+        state[i] = 0;
+    for (size_t i = 0; i < firLines.size(); ++i)
+        firLines[i] = 0;
+    firPosition = 0;
+    primed = false;
+}
+
+void FilterChain::prime(const double *first)
+{
+    size_t taps = fir.size();
+    for (int c = 0; c < channelCount; ++c)
+    {
+        // With a constant input x, every section outputs its DC gain times x, and its state is what keeps it there
+        double x = first[c];
+        for (size_t s = 0; s < sections.size(); ++s)
+        {
+            const Biquad &q = sections[s];
+            double dc = 1 + q.a1 + q.a2;
+            double y = dc != 0?(q.b0 + q.b1 + q.b2) / dc * x:0;
+            state[s * 2 * channelCount + c] = y - q.b0 * x;
+            state[(s * 2 + 1) * channelCount + c] = q.b2 * x - q.a2 * y;
+            x = y;
+        }
+
+        double *line = &firLines[c * 2 * taps];
+        for (size_t k = 0; k < 2 * taps; ++k)
+            line[k] = x;
+    }
+    primed = true;
+}
+
+void FilterChain::process(double *samples, size_t count)
+{
+    const int channels = channelCount;
+    if (count == 0)
+        return;
+    if (!primed)
+        prime(samples);
+
+    // Transposed direct form II, one section at a time over the whole batch
+    for (size_t s = 0; s < sections.size(); ++s)
+    {
+        const Biquad &q = sections[s];
+        double *z1 = &state[s * 2 * channels];
+        double *z2 = z1 + channels;
+        int c = 0;
+
+#ifdef FILTER_SSE2
+        __m128d b0 = _mm_set1_pd(q.b0), b1 = _mm_set1_pd(q.b1), b2 = _mm_set1_pd(q.b2);
+        __m128d a1 = _mm_set1_pd(q.a1), a2 = _mm_set1_pd(q.a2);
+        for (; c + 2 <= channels; c += 2)
+        {
+            __m128d s1 = _mm_loadu_pd(z1 + c);
+            __m128d s2 = _mm_loadu_pd(z2 + c);
+            double *x = samples + c;
+            for (size_t i = 0; i < count; ++i, x += channels)
+            {
+                __m128d in = _mm_loadu_pd(x);
+                __m128d out = _mm_add_pd(_mm_mul_pd(b0, in), s1);
+                s1 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b1, in), _mm_mul_pd(a1, out)), s2);
+                s2 = _mm_sub_pd(_mm_mul_pd(b2, in), _mm_mul_pd(a2, out));
+                _mm_storeu_pd(x, out);
+            }
+            _mm_storeu_pd(z1 + c, s1);
+            _mm_storeu_pd(z2 + c, s2);
+        }
+#endif
+        for (; c < channels; ++c)
+        {
+            double s1 = z1[c], s2 = z2[c];
+            double *x = samples + c;
+            for (size_t i = 0; i < count; ++i, x += channels)
+            {
+                double in = *x;
+                double out = q.b0 * in + s1;
+                s1 = q.b1 * in - q.a1 * out + s2;
+                s2 = q.b2 * in - q.a2 * out;
+                *x = out;
+            }
+            z1[c] = s1;
+            z2[c] = s2;
+        }
+    }
+
+    if (fir.empty())
+        return;
+
+    // The newest input is written at firPosition and firPosition + taps, so the last taps inputs are always the
+    // contiguous run starting at firPosition, newest first
+    size_t taps = fir.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        firPosition = firPosition == 0?taps - 1:firPosition - 1;
+        for (int c = 0; c < channels; ++c)
+        {
+            double *line = &firLines[c * 2 * taps];
+            double *x = &samples[i * channels + c];
+            line[firPosition] = line[firPosition + taps] = *x;
+
+            const double *recent = line + firPosition;
+            double sum0 = 0, sum1 = 0;
+            size_t k = 0;
+            for (; k + 2 <= taps; k += 2)
+            {
+                sum0 += fir[k] * recent[k];
+                sum1 += fir[k + 1] * recent[k + 1];
+            }
+            if (k < taps)
+                sum0 += fir[k] * recent[k];
+            *x = sum0 + sum1;
+        }
+    }
+}
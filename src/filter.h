@@ -0,0 +1,85 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <vector>
+#include <stddef.h>
+
+// What to filter out of a signal.  Highpass and lowpass together make a bandpass.
+struct FilterSettings
+{
+    FilterSettings(): highpass(0), lowpass(0), lowpassFIR(false), notch(0) {}
+
+    double highpass;        // cutoff in Hz, or 0 for none
+    double lowpass;         // cutoff in Hz, or 0 for none
+    bool lowpassFIR;        // linear phase FIR lowpass instead of IIR
+    double notch;           // mains frequency (50 or 60 Hz) to remove, or 0 for none
+};
+
+// A second order IIR section, normalized so that a0 is 1
+struct Biquad
+{
+    double b0, b1, b2, a1, a2;
+
+    // Designs from the Audio EQ Cookbook (R. Bristow-Johnson), with cutoff or center frequency f and quality factor q
+    static Biquad lowpass(double f, double sampleRate, double q);
+    static Biquad highpass(double f, double sampleRate, double q);
+    static Biquad notch(double f, double sampleRate, double q);
+};
+
+/*
+ * A streaming filter for a few channels at once: a cascade of biquads (4th order Butterworth highpass and lowpass,
+ * and a narrow notch), optionally followed by a windowed-sinc FIR lowpass.  Samples are interleaved, and the channels
+ * are filtered side by side, two at a time with SSE2, since the recursion of an IIR filter can't be vectorized along
+ * time.  Each section goes over the whole batch before the next one, so its coefficients stay in registers.
+ *
+ * Frequencies at or above Nyquist are ignored.  There is no allocation once configured.
+ */
+class FilterChain
+{
+public:
+    FilterChain();
+
+    // Design the filter for channels channels.  Clears the state.
+    void configure(const FilterSettings &settings, double sampleRate, int channels);
+
+    // Forget the past samples.  The filter then starts as if the first sample it gets had always been there, so
+    // that it doesn't ring from a step out of zero.
+    void reset();
+
+    // Filter count samples of every channel in place, with sample i of channel c at samples[i * channels + c]
+    void process(double *samples, size_t count);
+
+    bool empty() const { return sections.empty() && fir.empty(); }
+
+private:
+    void prime(const double *first);
+
+    int channelCount;
+    bool primed;
+    std::vector<Biquad> sections;
+    std::vector<double> state;              // per section, z1 of every channel then z2 of every channel
+
+    std::vector<double> fir;
+    std::vector<double> firLines;           // per channel, the last fir.size() inputs, twice so they are contiguous
+    size_t firPosition;                     // where the newest input is in the lines
+};
+
+#endif // FILTER_H
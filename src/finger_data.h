@@ -30,7 +30,10 @@
 struct FingerData
 {
     uint16_t staticTactile[FINGER_STATIC_TACTILE_COUNT];
+    uint16_t staticCompensated[FINGER_STATIC_TACTILE_COUNT];   // staticTactile above its adaptive baseline
+    uint16_t staticNoise;                                       // average noise floor of the taxels
     int16_t dynamicTactile[FINGER_DYNAMIC_TACTILE_COUNT];
+    int16_t dynamicFiltered[FINGER_DYNAMIC_TACTILE_COUNT];     // dynamicTactile through the acquisition filter
     int16_t accelerometer[3];
     int16_t gyroscope[3];
     int16_t magnetometer[3];
@@ -39,7 +42,8 @@ struct FingerData
 
 struct Fingers
 {
-    int64_t timestamp;
+    int64_t timestamp;      // reconstructed time the sample was taken, ns since the start of acquisition
+    int64_t arrival;        // time the data was read from the port, ns since the start of acquisition
     FingerData finger[FINGER_COUNT];
 };
 
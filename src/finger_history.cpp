@@ -0,0 +1,124 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "finger_history.h"
+
+FingerHistory::FingerHistory(size_t size):
+    sequencer(size),
+    times(size * TIME_COLUMNS),
+    taxels(size * FINGER_COUNT * TAXEL_COLUMNS),
+    channels(size * FINGER_COUNT * CHANNELS_PER_FINGER)
+{
+}
+
+void FingerHistory::push(const std::vector<Fingers> &samples)
+{
+    size_t size = capacity();
+    uint64_t h = sequencer.claim(samples.size());
+
+    // Write column by column, so every column is written sequentially
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        size_t at = (h + i) % size;
+        times[TIME_TIMESTAMP * size + at] = samples[i].timestamp;
+        times[TIME_ARRIVAL * size + at] = samples[i].arrival;
+    }
+
+    for (int f = 0; f < FINGER_COUNT; ++f)
+    {
+        for (int t = 0; t < FINGER_STATIC_TACTILE_COUNT; ++t)
+        {
+            uint16_t *raw = &taxels[(f * TAXEL_COLUMNS + TAXEL_RAW + t) * size];
+            uint16_t *compensated = &taxels[(f * TAXEL_COLUMNS + TAXEL_COMPENSATED + t) * size];
+            for (size_t i = 0; i < samples.size(); ++i)
+            {
+                size_t at = (h + i) % size;
+                raw[at] = samples[i].finger[f].staticTactile[t];
+                compensated[at] = samples[i].finger[f].staticCompensated[t];
+            }
+        }
+        uint16_t *noise = &taxels[(f * TAXEL_COLUMNS + TAXEL_NOISE) * size];
+        for (size_t i = 0; i < samples.size(); ++i)
+            noise[(h + i) % size] = samples[i].finger[f].staticNoise;
+
+        int16_t *column = &channels[f * CHANNELS_PER_FINGER * size];
+        for (size_t i = 0; i < samples.size(); ++i)
+        {
+            size_t at = (h + i) % size;
+            const FingerData &d = samples[i].finger[f];
+
+            for (int c = 0; c < FINGER_DYNAMIC_TACTILE_COUNT; ++c)
+            {
+                column[(CHANNEL_DYNAMIC + c) * size + at] = d.dynamicTactile[c];
+                column[(CHANNEL_DYNAMIC_FILTERED + c) * size + at] = d.dynamicFiltered[c];
+            }
+            for (int a = 0; a < 3; ++a)
+            {
+                column[(CHANNEL_ACCELEROMETER + a) * size + at] = d.accelerometer[a];
+                column[(CHANNEL_GYROSCOPE + a) * size + at] = d.gyroscope[a];
+                column[(CHANNEL_MAGNETOMETER + a) * size + at] = d.magnetometer[a];
+            }
+            column[CHANNEL_TEMPERATURE * size + at] = d.temperature;
+        }
+    }
+
+    sequencer.publish(h + samples.size());
+}
+
+uint64_t FingerHistory::copy(uint64_t from, uint64_t to, Fingers *out) const
+{
+    size_t size = capacity();
+
+    for (uint64_t s = from; s < to; ++s)
+    {
+        size_t at = s % size;
+        Fingers &o = out[s - from];
+
+        o.timestamp = times[TIME_TIMESTAMP * size + at];
+        o.arrival = times[TIME_ARRIVAL * size + at];
+        for (int f = 0; f < FINGER_COUNT; ++f)
+        {
+            FingerData &d = o.finger[f];
+            const int16_t *column = &channels[f * CHANNELS_PER_FINGER * size];
+
+            const uint16_t *taxel = &taxels[f * TAXEL_COLUMNS * size];
+
+            for (int t = 0; t < FINGER_STATIC_TACTILE_COUNT; ++t)
+            {
+                d.staticTactile[t] = taxel[(TAXEL_RAW + t) * size + at];
+                d.staticCompensated[t] = taxel[(TAXEL_COMPENSATED + t) * size + at];
+            }
+            d.staticNoise = taxel[TAXEL_NOISE * size + at];
+            for (int c = 0; c < FINGER_DYNAMIC_TACTILE_COUNT; ++c)
+            {
+                d.dynamicTactile[c] = column[(CHANNEL_DYNAMIC + c) * size + at];
+                d.dynamicFiltered[c] = column[(CHANNEL_DYNAMIC_FILTERED + c) * size + at];
+            }
+            for (int a = 0; a < 3; ++a)
+            {
+                d.accelerometer[a] = column[(CHANNEL_ACCELEROMETER + a) * size + at];
+                d.gyroscope[a] = column[(CHANNEL_GYROSCOPE + a) * size + at];
+                d.magnetometer[a] = column[(CHANNEL_MAGNETOMETER + a) * size + at];
+            }
+            d.temperature = column[CHANNEL_TEMPERATURE * size + at];
+        }
+    }
+
+    uint64_t intact = sequencer.intactFrom();
+    return intact > from?(intact < to?intact:to):from;
+}
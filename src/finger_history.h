@@ -0,0 +1,150 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FINGER_HISTORY_H
+#define FINGER_HISTORY_H
+
+#include <vector>
+#include "circular_buffer.h"
+#include "finger_data.h"
+
+/*
+ * History of the sensor data, stored by column: every channel (each taxel, each dynamic channel, each IMU axis, the
+ * temperature and the timestamps) has its own contiguous ring.  Looking at one channel over time, which is what the
+ * plots, the FFT and any statistics do, then reads a dense array instead of picking a few bytes out of every Fingers.
+ *
+ * Like SpmcRing, there is a single writer and any number of lock-free readers.  A reader gets a range with range(),
+ * takes spans of the channels it needs over that range, and checks with intact() afterwards that the writer didn't
+ * overwrite the range in the mean time.  Whole Fingers can still be read through a Reader, for code that needs all
+ * channels of a sample (e.g. the logger).
+ */
+class FingerHistory
+{
+public:
+    typedef RingReader<FingerHistory, Fingers> Reader;
+
+    struct Range
+    {
+        uint64_t start, end;    // Sequence numbers [start, end)
+        size_t size() const { return end - start; }
+    };
+
+    FingerHistory(size_t size);
+
+    size_t capacity() const { return sequencer.capacity(); }
+    uint64_t sequence() const { return sequencer.sequence(); }
+
+    // Writer side, to be called from a single thread
+    void push(const std::vector<Fingers> &samples);
+
+    // The samples after sequence number since (or the last count samples if since is 0)
+    Range range(uint64_t since, size_t count = 0) const
+    {
+        Range r;
+        sequencer.available(since, count, r.start, r.end);
+        return r;
+    }
+
+    // Whether the samples of a range were left untouched by the writer until now
+    bool intact(const Range &r) const { return sequencer.intactFrom() <= r.start; }
+
+    // Views of the channels over a range
+    RingSpan<int64_t> timestamps(const Range &r) const { return span(&times[0], TIME_TIMESTAMP, r); }
+    RingSpan<int64_t> arrivals(const Range &r) const { return span(&times[0], TIME_ARRIVAL, r); }
+    RingSpan<uint16_t> staticTactile(const Range &r, int finger, int taxel) const
+    {
+        return span(&taxels[0], finger * TAXEL_COLUMNS + TAXEL_RAW + taxel, r);
+    }
+    RingSpan<uint16_t> staticCompensated(const Range &r, int finger, int taxel) const
+    {
+        return span(&taxels[0], finger * TAXEL_COLUMNS + TAXEL_COMPENSATED + taxel, r);
+    }
+    RingSpan<uint16_t> staticNoise(const Range &r, int finger) const
+    {
+        return span(&taxels[0], finger * TAXEL_COLUMNS + TAXEL_NOISE, r);
+    }
+    RingSpan<int16_t> dynamicTactile(const Range &r, int finger, int channel) const
+    {
+        return span(&channels[0], finger * CHANNELS_PER_FINGER + CHANNEL_DYNAMIC + channel, r);
+    }
+    RingSpan<int16_t> dynamicFiltered(const Range &r, int finger, int channel) const
+    {
+        return span(&channels[0], finger * CHANNELS_PER_FINGER + CHANNEL_DYNAMIC_FILTERED + channel, r);
+    }
+    RingSpan<int16_t> accelerometer(const Range &r, int finger, int axis) const
+    {
+        return span(&channels[0], finger * CHANNELS_PER_FINGER + CHANNEL_ACCELEROMETER + axis, r);
+    }
+    RingSpan<int16_t> gyroscope(const Range &r, int finger, int axis) const
+    {
+        return span(&channels[0], finger * CHANNELS_PER_FINGER + CHANNEL_GYROSCOPE + axis, r);
+    }
+    RingSpan<int16_t> magnetometer(const Range &r, int finger, int axis) const
+    {
+        return span(&channels[0], finger * CHANNELS_PER_FINGER + CHANNEL_MAGNETOMETER + axis, r);
+    }
+    RingSpan<int16_t> temperature(const Range &r, int finger) const
+    {
+        return span(&channels[0], finger * CHANNELS_PER_FINGER + CHANNEL_TEMPERATURE, r);
+    }
+
+    // Gather [from, to) back into Fingers and return the first sequence number whose copy is intact (used by Reader)
+    uint64_t copy(uint64_t from, uint64_t to, Fingers *out) const;
+
+private:
+    // Layout of the signed channels of each finger
+    enum
+    {
+        CHANNEL_DYNAMIC = 0,
+        CHANNEL_DYNAMIC_FILTERED = CHANNEL_DYNAMIC + FINGER_DYNAMIC_TACTILE_COUNT,
+        CHANNEL_ACCELEROMETER = CHANNEL_DYNAMIC_FILTERED + FINGER_DYNAMIC_TACTILE_COUNT,
+        CHANNEL_GYROSCOPE = CHANNEL_ACCELEROMETER + 3,
+        CHANNEL_MAGNETOMETER = CHANNEL_GYROSCOPE + 3,
+        CHANNEL_TEMPERATURE = CHANNEL_MAGNETOMETER + 3,
+        CHANNELS_PER_FINGER = CHANNEL_TEMPERATURE + 1,
+    };
+    // Layout of the unsigned (static) channels of each finger
+    enum
+    {
+        TAXEL_RAW = 0,
+        TAXEL_COMPENSATED = TAXEL_RAW + FINGER_STATIC_TACTILE_COUNT,
+        TAXEL_NOISE = TAXEL_COMPENSATED + FINGER_STATIC_TACTILE_COUNT,
+        TAXEL_COLUMNS = TAXEL_NOISE + 1,
+    };
+    enum
+    {
+        TIME_TIMESTAMP = 0,
+        TIME_ARRIVAL = 1,
+        TIME_COLUMNS = 2,
+    };
+
+    template<typename T>
+    RingSpan<T> span(const T *columns, int column, const Range &r) const
+    {
+        return RingSpan<T>::of(columns + column * capacity(), capacity(), r.start, r.end);
+    }
+
+    RingSequencer sequencer;
+
+    // Every column holds capacity() values, and columns are stored one after the other
+    std::vector<int64_t> times;
+    std::vector<uint16_t> taxels;
+    std::vector<int16_t> channels;
+};
+
+#endif // FINGER_HISTORY_H
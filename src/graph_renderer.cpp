@@ -0,0 +1,124 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "graph_renderer.h"
+#include "mainwindow.h"
+#include <QElapsedTimer>
+#include <string.h>
+
+void FrameBuffer::publish(const unsigned char *rgba, int width, int height)
+{
+    // Reuse the back image, unless the size has changed
+    if (back.width() != width || back.height() != height)
+        back = QImage(width, height, QImage::Format_RGBA8888);
+    for (int y = 0; y < height; ++y)
+        memcpy(back.scanLine(y), rgba + (size_t)y * width * 4, (size_t)width * 4);
+
+    mutex.lock();
+    ready.swap(back);
+    fresh = true;
+    published = QSize(width, height);
+    mutex.unlock();
+}
+
+QSize FrameBuffer::size()
+{
+    QMutexLocker locker(&mutex);
+    return wanted;
+}
+
+bool FrameBuffer::resized()
+{
+    QMutexLocker locker(&mutex);
+    return !wanted.isEmpty() && !published.isEmpty() && wanted != published;
+}
+
+bool FrameBuffer::take(QImage &image)
+{
+    QMutexLocker locker(&mutex);
+
+    if (!fresh)
+        return false;
+
+    image.swap(ready);
+    fresh = false;
+    return true;
+}
+
+void FrameBuffer::resize(const QSize &size)
+{
+    QMutexLocker locker(&mutex);
+    wanted = size;
+}
+
+GraphRenderer::GraphRenderer(MainWindow *w_):
+    w(w_),
+    hasRequest(false),
+    averageCost(0)
+{
+}
+
+GraphRenderer::~GraphRenderer()
+{
+    requestInterruption();
+    mutex.lock();
+    wake.wakeOne();
+    mutex.unlock();
+    wait();
+}
+
+void GraphRenderer::request(const RenderRequest &r)
+{
+    QMutexLocker locker(&mutex);
+
+    // One-time actions of a request that was never rendered are carried over
+    bool resetBaseline = hasRequest && pending.resetBaseline;
+
+    pending = r;
+    pending.resetBaseline = pending.resetBaseline || resetBaseline;
+    hasRequest = true;
+
+    wake.wakeOne();
+}
+
+void GraphRenderer::run()
+{
+    while (true)
+    {
+        mutex.lock();
+        while (!hasRequest && !isInterruptionRequested())
+            wake.wait(&mutex);
+        if (isInterruptionRequested())
+        {
+            mutex.unlock();
+            break;
+        }
+        RenderRequest r = pending;
+        hasRequest = false;
+        mutex.unlock();
+
+        QElapsedTimer timer;
+        timer.start();
+        if (w->renderGraphs(r))
+        {
+            // Smooth the cost, so the frame rate doesn't jump around with every frame
+            int cost = timer.nsecsElapsed() / 1000;
+            averageCost.store((averageCost.load() * 7 + cost) / 8);
+        }
+    }
+}
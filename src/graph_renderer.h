@@ -0,0 +1,114 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GRAPH_RENDERER_H
+#define GRAPH_RENDERER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <QAtomicInt>
+#include <stdint.h>
+#include "decimate.h"
+#include "spectrum.h"
+
+class MainWindow;
+
+// What to render in one frame, as decided by the GUI
+struct RenderRequest
+{
+    int tab;                        // the shown tab
+    int device;                     // id of the shown device, or -1
+    bool staticRaw;
+    bool static3D;                  // lit 3D surface instead of the heatmap for the static sensors
+    bool resetBaseline;
+    int64_t dynamicSpan, imuSpan;   // time span of the graphs in ns, or 0 for the recent history
+    DecimationMethod decimation;
+    bool dynamicFiltered;           // the dynamic sensors after the acquisition filter instead of raw
+    unsigned int spectrumSegment;   // samples per segment of the spectrum
+    unsigned int spectrumOverlap;   // overlap of the segments, in percent
+    SpectrumWindow spectrumWindow;
+    bool spectrogram;               // spectrogram instead of the power spectral density
+};
+
+/*
+ * A triple-buffered image.  The renderer draws into the back image and publishes it, which swaps it with the ready
+ * image.  The GUI takes the ready image whenever it wants by swapping it with the one it was showing; if the renderer
+ * publishes twice in between, the older frame is simply dropped.  The three images only ever change hands, so once
+ * they have the right size, no frame is allocated or copied other than the single copy out of the renderer.
+ *
+ * The GUI also tells the renderer the size, in pixels, at which the image is shown, so that it is rendered at that
+ * size instead of being scaled.
+ */
+class FrameBuffer
+{
+public:
+    FrameBuffer(): fresh(false) {}
+
+    // Renderer side: publish an RGBA image
+    void publish(const unsigned char *rgba, int width, int height);
+
+    // Renderer side: the size the image should have, which is empty until the GUI sets it
+    QSize size();
+
+    // Renderer side: whether the image should be rendered again only because its size has changed
+    bool resized();
+
+    // GUI side: swap the given image with the newest one, if there is one that was not taken yet
+    bool take(QImage &image);
+
+    // GUI side: set the size the image is shown at
+    void resize(const QSize &size);
+
+private:
+    QMutex mutex;
+    QImage ready, back;
+    bool fresh;
+    QSize wanted, published;
+};
+
+/*
+ * Renders the graphs on its own thread, so that the GUI thread (input handling, logging) is never held up by mathgl.
+ * The GUI posts a request every frame; if the renderer is still busy with the previous one, the new request replaces
+ * any request that is still waiting.
+ */
+class GraphRenderer: public QThread
+{
+public:
+    GraphRenderer(MainWindow *w_);
+    ~GraphRenderer();
+
+    void request(const RenderRequest &r);
+    void run();
+
+    // Average time taken by the frames that were actually rendered, in us
+    int renderCost() const { return averageCost.load(); }
+
+private:
+    MainWindow *w;
+
+    QMutex mutex;
+    QWaitCondition wake;
+    RenderRequest pending;
+    bool hasRequest;
+
+    QAtomicInt averageCost;
+};
+
+#endif // GRAPH_RENDERER_H
@@ -18,6 +18,57 @@
 
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "device.h"
+#include "communicator.h"
+#include "decimate.h"
+#include "heatmap.h"
+#include "strip_chart.h"
+
+// Time constant with which the color scale of the static sensors zooms back in after a peak
+#define STATIC_RANGE_DECAY_S 0.4
+
+// Drift compensated taxels within this many times their noise floor are shown as 0
+#define STATIC_NOISE_GATE 3
+
+// The color scale of the heatmap is rounded up to this, so its color bar needs redrawing only once in a while
+#define STATIC_SCALE_STEP 1000
+
+// The long term history of a channel, ready for plotting
+struct SummaryPlot
+{
+    mglData time, min, max;
+};
+
+/*
+ * Fetch the min/max envelope of a channel over the last span ns, at the resolution that best fits the width of the
+ * graph.  Returns false if there is nothing to show yet.
+ */
+static bool summaryData(const HistoryPyramid &summary, int channel, int64_t span, size_t width, double scale,
+                        SummaryPlot &plot)
+{
+    int64_t to = summary.newest();
+    if (to < 0)
+        return false;
+    int64_t from = to - span;
+
+    HistoryPyramid::Series series;
+    int level = summary.chooseLevel(from, to, width);
+    if (!summary.query(level, channel, from, to, series) || series.time.empty())
+        return false;
+
+    size_t n = series.time.size();
+    plot.time.Create(n);
+    plot.min.Create(n);
+    plot.max.Create(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        plot.time.a[i] = series.time[i] / 1e9;
+        plot.min.a[i] = series.min[i] * scale;
+        plot.max.a[i] = series.max[i] * scale;
+    }
+
+    return true;
+}
 
 void MainWindow::initUiGraphs()
 {
@@ -26,122 +77,329 @@ void MainWindow::initUiGraphs()
         // TODO: see if commented-out graph settings are needed
 
         // Put placeholders for the graphs
-        staticGraphs[f].widget = new QLabel(this);
-        staticGraphs[f].widget->setAlignment(Qt::AlignCenter);
+        staticGraphs[f].widget = new PlotWidget(&staticGraphs[f].frame, 600, 500, this);
         ui->staticGraphs->addWidget(staticGraphs[f].widget);
 
-        dynamicGraphs[f].widget = new QLabel(this);
-        dynamicGraphs[f].fftWidget = new QLabel(
-#if READ_DATA_PERIOD_MS != 1
-                                                "FFT Not Supported for not-1KHz Acquisition",
-#endif
-                                                this);
-        dynamicGraphs[f].widget->setAlignment(Qt::AlignCenter);
-        dynamicGraphs[f].fftWidget->setAlignment(Qt::AlignCenter);
+        dynamicGraphs[f].widget = new PlotWidget(&dynamicGraphs[f].frame, 600, 250, this);
+        dynamicGraphs[f].fftWidget = new PlotWidget(&dynamicGraphs[f].fftFrame, 600, 250, this);
         ui->dynamicGraphs->addWidget(dynamicGraphs[f].widget, 0, f);
         ui->dynamicGraphs->addWidget(dynamicGraphs[f].fftWidget, 1, f);
 
-        imuGraphs[f].widgetAccel = new QLabel(this);
-        imuGraphs[f].widgetGyro = new QLabel(this);
-        imuGraphs[f].widgetAccel->setAlignment(Qt::AlignCenter);
-        imuGraphs[f].widgetGyro->setAlignment(Qt::AlignCenter);
+        imuGraphs[f].widgetAccel = new PlotWidget(&imuGraphs[f].frameAccel, 600, 250, this);
+        imuGraphs[f].widgetGyro = new PlotWidget(&imuGraphs[f].frameGyro, 600, 250, this);
         ui->accelGraphs->addWidget(imuGraphs[f].widgetAccel);
         ui->gyroGraphs->addWidget(imuGraphs[f].widgetGyro);
 
-        // Allocate data and graph objects for the eventual rendering
-        staticGraphs[f].data.Create(FINGER_STATIC_TACTILE_ROW + 2, FINGER_STATIC_TACTILE_COL + 2);
-        staticGraphs[f].graph = new mglGraph(0, 600, 500);
-        staticGraphs[f].graph->Rotate(60, 250);
-        staticGraphs[f].graph->Light(true);
-        //staticGraphs[f].graph->SetTuneTicks(true);
-        staticGraphs[f].graph->SetTicks('x', 1, 0);
-        staticGraphs[f].graph->Alpha(false);
-
-        dynamicGraphs[f].data.Create(4000 / READ_DATA_PERIOD_MS);
-        dynamicGraphs[f].fft.Create(2048);
-        dynamicGraphs[f].timestamps.Create(4000 / READ_DATA_PERIOD_MS);
-        dynamicGraphs[f].fftIn = new double[4096];
-        dynamicGraphs[f].fftOut = new fftw_complex[4096];   // TODO: do we need 4096 or 2048?
-        dynamicGraphs[f].fftPlan = fftw_plan_dft_r2c_1d(4096, dynamicGraphs[f].fftIn, dynamicGraphs[f].fftOut, FFTW_ESTIMATE);
-        dynamicGraphs[f].graph = new mglGraph(0, 600, 250);
-        dynamicGraphs[f].graph->SetTicks('x', 1, 0);
-        //dynamicGraphs[f].graph->SetTicksVal(???);
-        //dynamicGraphs[f].graph->SetLight(true);
-        dynamicGraphs[f].fftGraph = new mglGraph(0, 600, 250);
-        dynamicGraphs[f].fftGraph->SetTicks('x', 250, 0);
-
-        imuGraphs[f].dataAccel.Create(2000 / READ_DATA_PERIOD_MS, 3);
-        imuGraphs[f].dataGyro.Create(2000 / READ_DATA_PERIOD_MS, 3);
-        imuGraphs[f].timestamps.Create(2000 / READ_DATA_PERIOD_MS);
-        imuGraphs[f].graphAccel = new mglGraph(0, 600, 250);
-        imuGraphs[f].graphAccel->SetTicks('x', 1, 0);
-        //imuGraphs[f].graphAccel->SetTicksVal(???);
-        //imuGraphs[f].graphAccel->SetLight(true);
-        imuGraphs[f].graphGyro = new mglGraph(0, 600, 250);
-        imuGraphs[f].graphGyro->SetTicks('x', 1, 0);
-        //imuGraphs[f].graphGyro->SetTicksVal(???);
-        //imuGraphs[f].graphGyro->SetLight(true);
+        // The graph objects are created by createGraphs() the first time their tab is shown, data arrays are sized
+        // in configureGraphs() once a device is shown, and the spectrum on first use
+        staticGraphs[f].graph = NULL;
+        staticGraphs[f].heatmapGraph = NULL;
+        staticGraphs[f].heatmapHigh = 0;
+        staticGraphs[f].maxRange = 0;
+        staticGraphs[f].rangeTime = 0;
+
+        dynamicGraphs[f].graph = NULL;
+        dynamicGraphs[f].fftGraph = NULL;
+        dynamicGraphs[f].spectrumSequence = 0;
+        dynamicGraphs[f].stripValid = false;
+        dynamicGraphs[f].spectrogramValid = false;
+        dynamicGraphs[f].spectrogramFitTime = 0;
+
+        imuGraphs[f].graphAccel = NULL;
+        imuGraphs[f].graphGyro = NULL;
+        imuGraphs[f].stripValid = false;
+    }
+}
+
+void MainWindow::createGraphs(int tab)
+{
+    for (int f = 0; f < FINGER_COUNT; ++f)
+        switch (tab)
+        {
+        case 1:
+            if (staticGraphs[f].graph != NULL)
+                break;
+            staticGraphs[f].data.Create(FINGER_STATIC_TACTILE_ROW + 2, FINGER_STATIC_TACTILE_COL + 2);
+            staticGraphs[f].graph = new mglGraph(0, 600, 500);
+            staticGraphs[f].graph->Rotate(60, 250);
+            staticGraphs[f].graph->Light(true);
+            //staticGraphs[f].graph->SetTuneTicks(true);
+            staticGraphs[f].graph->SetTicks('x', 1, 0);
+            staticGraphs[f].graph->Alpha(false);
+            staticGraphs[f].heatmapGraph = new mglGraph(0, 600, 500);
+            break;
+        case 2:
+            if (dynamicGraphs[f].graph != NULL)
+                break;
+            dynamicGraphs[f].graph = new mglGraph(0, 600, 250);
+            dynamicGraphs[f].graph->SetTicks('x', 1, 0);
+            //dynamicGraphs[f].graph->SetTicksVal(???);
+            //dynamicGraphs[f].graph->SetLight(true);
+            dynamicGraphs[f].fftGraph = new mglGraph(0, 600, 250);
+            dynamicGraphs[f].fftGraph->SetTicks('x', 250, 0);
+            break;
+        case 3:
+            if (imuGraphs[f].graphAccel != NULL)
+                break;
+            imuGraphs[f].graphAccel = new mglGraph(0, 600, 250);
+            imuGraphs[f].graphAccel->SetTicks('x', 1, 0);
+            //imuGraphs[f].graphAccel->SetTicksVal(???);
+            //imuGraphs[f].graphAccel->SetLight(true);
+            imuGraphs[f].graphGyro = new mglGraph(0, 600, 250);
+            imuGraphs[f].graphGyro->SetTicks('x', 1, 0);
+            //imuGraphs[f].graphGyro->SetTicksVal(???);
+            //imuGraphs[f].graphGyro->SetLight(true);
+            break;
+        default:
+            break;
+        }
+}
+
+void MainWindow::configureGraphs(Device *device)
+{
+    graphsDevice = device->id;
+
+    for (int f = 0; f < FINGER_COUNT; ++f)
+    {
+        // The dynamic graph shows the whole history, the IMU graphs half of it
+        dynamicGraphs[f].data.Create(device->historySamples);
+        dynamicGraphs[f].timestamps.Create(device->historySamples);
+        imuGraphs[f].dataAccel.Create(device->historySamples / 2, 3);
+        imuGraphs[f].dataGyro.Create(device->historySamples / 2, 3);
+        imuGraphs[f].timestamps.Create(device->historySamples / 2);
+        dynamicGraphs[f].nextSequence = dynamicGraphs[f].filled = 0;
+        imuGraphs[f].nextSequence = imuGraphs[f].filled = 0;
+        dynamicGraphs[f].spectrumSequence = 0;
+        dynamicGraphs[f].spectrum.clear();
+        dynamicGraphs[f].spectrogram.clear();
+        dynamicGraphs[f].stripValid = imuGraphs[f].stripValid = false;
+        dynamicGraphs[f].spectrogramValid = false;
     }
 }
 
+// Publish what a graph has drawn, for the GUI to show
+static void publish(FrameBuffer &frame, mglGraph *g)
+{
+    frame.publish(g->GetRGBA(), g->GetWidth(), g->GetHeight());
+}
+
+// Lay out a strip chart in a graph whose axes and labels were just drawn for the range [-window, 0] x [low, high]
+static void layoutStrip(StripChart &strip, mglGraph *g, double window, double low, double high, int traces)
+{
+    // Screen coordinates are from the top left, like the image
+    mglPoint topLeft = g->CalcScr(mglPoint(-window, high));
+    mglPoint bottomRight = g->CalcScr(mglPoint(0, low));
+    strip.configure(g->GetRGBA(), g->GetWidth(), g->GetHeight(), (int)topLeft.x, (int)topLeft.y,
+                    (int)bottomRight.x + 1, (int)bottomRight.y + 1, window, low, high, traces);
+}
+
+// Draw the title and color bar of a heatmap and lay it out in the rest of the graph
+static void layoutHeatmap(Heatmap &heatmap, mglGraph *g, int f, double low, double high)
+{
+    g->Clf();
+    g->SetRanges(0, 1, 0, 1);
+    g->SetRange('c', low, high);
+    g->Colorbar("{B,0}{b,0.17}{c,0.25}{y,0.35}{r,0.55}{R,0.85}>");
+    if (f==0)
+        g->Puts(mglPoint(0.5,1.1),"Sensor 1","a");
+    else
+        g->Puts(mglPoint(0.5,1.1),"Sensor 2","a");
+
+    // Screen coordinates are from the top left, like the image
+    mglPoint topLeft = g->CalcScr(mglPoint(0, 1));
+    mglPoint bottomRight = g->CalcScr(mglPoint(1, 0));
+    heatmap.setOverlay(g->GetRGBA(), g->GetWidth(), g->GetHeight(), (int)topLeft.x, (int)topLeft.y,
+                       (int)bottomRight.x + 1, (int)bottomRight.y + 1);
+}
+
+// Make a graph as large as its widget, in pixels.  Returns whether the size has changed, which also clears the graph.
+static bool fit(mglGraph *g, FrameBuffer &frame)
+{
+    QSize size = frame.size();
+    if (size.isEmpty() || (size.width() == g->GetWidth() && size.height() == g->GetHeight()))
+        return false;
+
+    g->SetSize(size.width(), size.height());
+    return true;
+}
+
 void MainWindow::slowUiUpdate()
 {
-    updateGraphs();
+    // Allow the acquisition threads to notify again, once per frame
+    for (size_t d = 0; d < devices.size(); ++d)
+        devices[d]->notifyPending.store(0);
+
+    // Show what the renderer has finished since the last frame, and ask it for the next frame
+    showFrames();
+
+    Device *device = shownDevice();
+    RenderRequest request;
+    request.tab = ui->alltabs->currentIndex();
+    request.device = device?device->id:-1;
+    request.staticRaw = ui->staticRawValues->isChecked();
+    request.static3D = ui->static3D->isChecked();
+    request.resetBaseline = pendingBaselineReset;
+    request.dynamicSpan = (int64_t)ui->dynamicTimeSpan->currentData().toUInt() * 1000000000;
+    request.imuSpan = (int64_t)ui->imuTimeSpan->currentData().toUInt() * 1000000000;
+    request.decimation = (DecimationMethod)ui->plotDecimation->currentData().toInt();
+    request.dynamicFiltered = ui->dynamicFiltered->isChecked();
+    request.spectrumSegment = ui->spectrumSegment->currentData().toUInt();
+    request.spectrumOverlap = ui->spectrumOverlap->currentData().toUInt();
+    request.spectrumWindow = (SpectrumWindow)ui->spectrumWindow->currentData().toInt();
+    request.spectrogram = ui->spectrumView->currentIndex() == 1;
+    renderer->request(request);
+
+    pendingBaselineReset = false;
+
+    // Refresh as fast as possible (50 fps), but slow down if rendering would use more than the budgeted share of a core
+    double budget = ui->renderBudget->currentData().toDouble();
+    int interval = renderer->renderCost() / 1000.0 / budget;
+    if (interval < 20)
+        interval = 20;
+    else if (interval > 1000)
+        interval = 1000;
+    if (interval != renderTicker->interval())
+        renderTicker->setInterval(interval);
 }
 
-void MainWindow::updateGraphs()
+void MainWindow::showFrames()
 {
-    switch (ui->alltabs->currentIndex())
+    for (int f = 0; f < FINGER_COUNT; ++f)
+    {
+        staticGraphs[f].widget->refresh();
+        dynamicGraphs[f].widget->refresh();
+        dynamicGraphs[f].fftWidget->refresh();
+        imuGraphs[f].widgetAccel->refresh();
+        imuGraphs[f].widgetGyro->refresh();
+    }
+}
+
+bool MainWindow::framesResized(int tab)
+{
+    for (int f = 0; f < FINGER_COUNT; ++f)
+        switch (tab)
+        {
+        case 1:
+            if (staticGraphs[f].frame.resized())
+                return true;
+            break;
+        case 2:
+            if (dynamicGraphs[f].frame.resized() || dynamicGraphs[f].fftFrame.resized())
+                return true;
+            break;
+        case 3:
+            if (imuGraphs[f].frameAccel.resized() || imuGraphs[f].frameGyro.resized())
+                return true;
+            break;
+        default:
+            break;
+        }
+
+    return false;
+}
+
+bool MainWindow::renderGraphs(const RenderRequest &request)
+{
+    for (int f = 0; f < FINGER_COUNT; ++f)
+    {
+        if (request.resetBaseline)
+            staticGraphs[f].maxRange = 0;
+    }
+
+    // The GUI doesn't remove devices while they are being rendered
+    QMutexLocker locker(&devicesMutex);
+    Device *device = findDevice(request.device);
+
+    // Skip the frame if neither the data nor the way it is shown has changed
+    uint64_t sequence = device?device->fingerData.sequence():0;
+    bool dirty = !lastRenderValid || sequence != lastSequence || request.resetBaseline ||
+                 framesResized(request.tab) ||
+                 request.tab != lastRequest.tab || request.device != lastRequest.device ||
+                 request.staticRaw != lastRequest.staticRaw || request.static3D != lastRequest.static3D ||
+                 request.dynamicSpan != lastRequest.dynamicSpan ||
+                 request.imuSpan != lastRequest.imuSpan || request.decimation != lastRequest.decimation ||
+                 request.dynamicFiltered != lastRequest.dynamicFiltered ||
+                 request.spectrumSegment != lastRequest.spectrumSegment ||
+                 request.spectrumOverlap != lastRequest.spectrumOverlap ||
+                 request.spectrumWindow != lastRequest.spectrumWindow ||
+                 request.spectrogram != lastRequest.spectrogram;
+
+    // The dynamic graphs only read new data, so switching between the raw and filtered data starts them over
+    if (lastRenderValid && request.dynamicFiltered != lastRequest.dynamicFiltered)
+        for (int f = 0; f < FINGER_COUNT; ++f)
+        {
+            dynamicGraphs[f].nextSequence = dynamicGraphs[f].filled = 0;
+            dynamicGraphs[f].stripValid = false;
+        }
+
+    lastRequest = request;
+    lastSequence = sequence;
+    lastRenderValid = true;
+    if (!dirty)
+        return false;
+
+    // Resize the graphs if the shown device acquires at a different rate or keeps a different history
+    if (device != NULL && device->id != graphsDevice)
+        configureGraphs(device);
+    createGraphs(request.tab);
+
+    switch (request.tab)
     {
     case 1:
-        updateGraphStatic();
+        updateGraphStatic(device, request);
         break;
     case 2:
-        updateGraphDynamic();
+        updateGraphDynamic(device, request);
         break;
     case 3:
-        updateGraphIMU();
+        updateGraphIMU(device, request);
         break;
     default:
         break;
     }
+
+    return true;
 }
 
-void MainWindow::updateGraphStatic()
+void MainWindow::updateGraphStatic(Device *device, const RenderRequest &request)
 {
     for (int f = 0; f < FINGER_COUNT; ++f)
-        staticGraphs[f].graph->Clf();
+    {
+        // Resizing the graph resets the view as well
+        if (fit(staticGraphs[f].graph, staticGraphs[f].frame))
+            staticGraphs[f].graph->Rotate(60, 250);
+        if (request.static3D)
+            staticGraphs[f].graph->Clf();
+        if (fit(staticGraphs[f].heatmapGraph, staticGraphs[f].frame))
+            staticGraphs[f].heatmapHigh = 0;
+    }
 
-    if (fingerData.empty())
+    Fingers fd;
+    if (device == NULL || !device->plotReader.back(fd))
         return;
-    Fingers fd = fingerData.back();
 
     for (int f = 0; f < FINGER_COUNT; ++f)
     {
-        if (staticGraphs[f].shouldResetBaseline)
-        {
-            staticGraphs[f].shouldResetBaseline = false;
-            for (int i = 0; i < FINGER_STATIC_TACTILE_COUNT; ++i)
-                staticGraphs[f].baseline[i] = fd.finger[f].staticTactile[i];
-        }
-
-        // Slowly reduce maxRange to zoom back in
-        staticGraphs[f].maxRange *= 0.95;
+        // Slowly reduce maxRange to zoom back in, by the time that passed rather than per frame, since the frame rate
+        // varies
+        double elapsed = (fd.timestamp - staticGraphs[f].rangeTime) / 1e9;
+        if (elapsed > 0)
+            staticGraphs[f].maxRange *= exp(-elapsed / STATIC_RANGE_DECAY_S);
+        staticGraphs[f].rangeTime = fd.timestamp;
         if (staticGraphs[f].maxRange < 3000)
             staticGraphs[f].maxRange = 3000;
 
-        // Take latest data
+        // Take latest data.  The baseline is tracked by the acquisition thread, which also removes it.
+        unsigned int noiseGate = STATIC_NOISE_GATE * fd.finger[f].staticNoise;
         for (int i = 0; i < FINGER_STATIC_TACTILE_COUNT; ++i)
         {
             uint16_t d = fd.finger[f].staticTactile[i];
 
-            if (!ui->staticRawValues->isChecked())
+            if (!request.staticRaw)
             {
-                // Remove baseline.  If going lower than baseline, show as 0
-                if (d < staticGraphs[f].baseline[i])
+                d = fd.finger[f].staticCompensated[i];
+                if (d <= noiseGate)
                     d = 0;
-                else
-                    d -= staticGraphs[f].baseline[i];
             }
 
             // Keep maximum data for
@@ -154,6 +412,29 @@ void MainWindow::updateGraphStatic()
         }
 
         mglGraph *g = staticGraphs[f].graph;
+
+        // Unless the 3D surface is asked for, draw a flat heatmap, with the long side of the sensor horizontal
+        if (!request.static3D)
+        {
+            const int cols = FINGER_STATIC_TACTILE_COL + 2;
+            const int rows = FINGER_STATIC_TACTILE_ROW + 2;
+            float grid[cols * rows];
+            for (int r = 0; r < rows; ++r)
+                for (int c = 0; c < cols; ++c)
+                    grid[r * cols + c] = staticGraphs[f].data.a[c * rows + r];
+
+            Heatmap &heatmap = staticGraphs[f].heatmap;
+            double high = ceil((staticGraphs[f].maxRange + 800) / STATIC_SCALE_STEP) * STATIC_SCALE_STEP;
+            if (high != staticGraphs[f].heatmapHigh)
+            {
+                layoutHeatmap(heatmap, staticGraphs[f].heatmapGraph, f, -800, high);
+                staticGraphs[f].heatmapHigh = high;
+            }
+            heatmap.render(grid, cols, rows, -800, high);
+            staticGraphs[f].frame.publish(heatmap.rgba(), heatmap.width(), heatmap.height());
+            continue;
+        }
+
         g->SetRanges(0, 6, 0, 4, -800, staticGraphs[f].maxRange + 800);
 
         // Interpolate the data for the graph to look nicer
@@ -164,173 +445,346 @@ void MainWindow::updateGraphStatic()
             g->Puts(mglPoint(0.6,-0.22),"Sensor 1","a");
         else
             g->Puts(mglPoint(0.6,-0.22),"Sensor 2","a");
-        staticGraphs[f].widget->setPixmap(QPixmap::fromImage(
-              QImage(g->GetRGBA(), g->GetWidth(), g->GetHeight(), QImage::Format_RGBA8888)));
+        publish(staticGraphs[f].frame, g);
     }
 }
 
-void MainWindow::updateGraphDynamic()
+void MainWindow::updateGraphDynamic(Device *device, const RenderRequest &request)
 {
     for (int f = 0; f < FINGER_COUNT; ++f)
     {
-        dynamicGraphs[f].graph->Clf();
-        if (dynamicGraphs[f].shouldUpdateFFTGraph)
-            dynamicGraphs[f].fftGraph->Clf();
+        mglGraph *g = dynamicGraphs[f].graph;
+        if (fit(g, dynamicGraphs[f].frame))
+            dynamicGraphs[f].stripValid = false;
+
+        // Plots are reduced to two points per pixel
+        if (dynamicGraphs[f].plotX.GetNx() != 2 * g->GetWidth())
+        {
+            dynamicGraphs[f].plotX.Create(2 * g->GetWidth());
+            dynamicGraphs[f].plotY.Create(2 * g->GetWidth());
+        }
+        if (fit(dynamicGraphs[f].fftGraph, dynamicGraphs[f].fftFrame) || !request.spectrogram)
+            dynamicGraphs[f].spectrogramValid = false;
     }
 
-    if (fingerData.empty())
+    if (device == NULL)
         return;
 
-    std::vector<Fingers> fd;
-    fingerData.extract(fd);
-
     for (int f = 0; f < FINGER_COUNT; ++f)
     {
-        // If not enough data, don't calculate FFT
-        if (fd.size() < 4096)
-            dynamicGraphs[f].shouldUpdateFFTGraph = false;
-
-        int64_t oldestTime, newestTime;
-
-        // Take data and store for plotting
+        // Look only at the data that arrived since the last update, and no more than the graph holds.  After a restart,
+        // this keeps the read away from the oldest samples, which the acquisition overwrites next.
         size_t graphDataCount = dynamicGraphs[f].data.GetNx();
-        size_t start = graphDataCount < fd.size()?fd.size() - graphDataCount:0;
-        size_t end = fd.size();
+        FingerHistory::Range range = device->fingerData.range(dynamicGraphs[f].nextSequence, graphDataCount);
+        RingSpan<int16_t> dynamic = request.dynamicFiltered?device->fingerData.dynamicFiltered(range, f, 0):
+                                                            device->fingerData.dynamicTactile(range, f, 0);
+        RingSpan<int64_t> timestamps = device->fingerData.timestamps(range);
+        size_t filled = dynamicGraphs[f].filled;
+        size_t count = range.size();
+        size_t drop = filled + count > graphDataCount?filled + count - graphDataCount:0;     // Old data to make room
+
+        // Shift the old data and append the new
+        filled -= drop;
+        memmove(dynamicGraphs[f].data.a, dynamicGraphs[f].data.a + drop, filled * sizeof *dynamicGraphs[f].data.a);
+        memmove(dynamicGraphs[f].timestamps.a, dynamicGraphs[f].timestamps.a + drop, filled * sizeof *dynamicGraphs[f].timestamps.a);
+        for (size_t i = 0; i < count; ++i)
+        {
+            dynamicGraphs[f].data.a[filled + i] = dynamic[i] * 1.024 / 32767;     // Note: 1.024 is voltage applied to sensor
+            dynamicGraphs[f].timestamps.a[filled + i] = timestamps[i] / 1e9;
+        }
+        filled += count;
+        dynamicGraphs[f].filled = filled;
+        dynamicGraphs[f].nextSequence = range.end;
 
-        oldestTime = fd[start].timestamp;
-        newestTime = fd[end - 1].timestamp;
-        int64_t lastTimestamp = oldestTime - 1;
-        for (size_t i = start; i < end; ++i)
+        // If the acquisition overwrote the data while it was being read, start over on the next update
+        if (!device->fingerData.intact(range))
         {
-            int16_t d = fd[i].finger[f].dynamicTactile[0];
-            dynamicGraphs[f].data.a[i - start] = d * 1.024 / 32767;     // Note: 1.024 is voltage applied to sensor
-            int64_t t = fd[i].timestamp;
-            // Non-realtime operating systems may read multiple messages in the same millisecond, so this just spaces them out
-            if (t <= lastTimestamp)
-                t = lastTimestamp + 1;
-            dynamicGraphs[f].timestamps.a[i - start] = t / 1000.0f;
-            lastTimestamp = t;
+            dynamicGraphs[f].filled = 0;
+            dynamicGraphs[f].nextSequence = 0;
+            dynamicGraphs[f].stripValid = false;
+            continue;
         }
+        if (filled == 0)
+            continue;
 
+        // When zoomed out, show the envelope of the long term history instead of the raw data
         mglGraph *g = dynamicGraphs[f].graph;
-        g->SetRanges(oldestTime / 1000.0f, newestTime / 1000.0f, -1, 1);
-
-        g->Axis();
-        g->Label('y',"mV",0);
-        g->Label('x',"s",0);
-        g->Plot(mglData(dynamicGraphs[f].timestamps.a, end - start), mglData(dynamicGraphs[f].data.a, end - start));
-        if (f==0)
-            g->Puts(mglPoint(0.5,1.1),"Raw Data - Sensor 1","a");
+        int64_t span = request.dynamicSpan;
+        SummaryPlot summary;
+        bool summarized = span != 0 &&
+                          summaryData(device->summary, f * SUMMARY_CHANNELS_PER_FINGER + SUMMARY_DYNAMIC, span,
+                                      g->GetWidth(), 1.024 / 32767, summary);
+
+        // The recent history scrolls by, so with min/max decimation only the new samples need to be drawn
+        if (!summarized && request.decimation == DECIMATION_MIN_MAX)
+            updateStripDynamic(f, device, count);
         else
-            g->Puts(mglPoint(0.5,1.1),"Raw Data - Sensor 2","a");
-        dynamicGraphs[f].widget->setPixmap(QPixmap::fromImage(
-              QImage(g->GetRGBA(), g->GetWidth(), g->GetHeight(), QImage::Format_RGBA8888)));
-
-        // If time to do FFT, do it
-        if (dynamicGraphs[f].shouldUpdateFFTGraph)
         {
-            dynamicGraphs[f].shouldUpdateFFTGraph = false;
-
-            double maxPower = 0;
+            dynamicGraphs[f].stripValid = false;
+            g->Clf();
+            if (summarized)
+                g->SetRanges(summary.time.a[0], summary.time.a[summary.time.GetNx() - 1], -1, 1);
+            else
+                g->SetRanges(dynamicGraphs[f].timestamps.a[0], dynamicGraphs[f].timestamps.a[filled - 1], -1, 1);
 
-            start = fd.size() > 4096?fd.size() - 4096:0;
-            end = fd.size();
-            for (size_t i = start; i < end; ++i)
-                dynamicGraphs[f].fftIn[i - start] = fd[i].finger[f].dynamicTactile[0];
-            fftw_execute(dynamicGraphs[f].fftPlan);
-            for (size_t i = 0; i < 2048; ++i)
+            g->Axis();
+            g->Label('y',"mV",0);
+            g->Label('x',"s",0);
+            if (summarized)
+                g->Region(summary.time, summary.min, summary.max, "b");
+            else if (request.decimation == DECIMATION_NONE)
+                g->Plot(mglData(dynamicGraphs[f].timestamps.a, filled), mglData(dynamicGraphs[f].data.a, filled));
+            else
             {
-                fftw_complex &c = dynamicGraphs[f].fftOut[i];
-                double power = sqrt(c[0] * c[0] + c[1] * c[1]);     // The amplitude of the Fourier Transform for each frequency
-                dynamicGraphs[f].fft.a[i] = power;
-                if (power > maxPower)
-                    maxPower = power;
+                size_t points = decimate(request.decimation,
+                                         dynamicGraphs[f].timestamps.a, dynamicGraphs[f].data.a, filled, g->GetWidth(),
+                                         dynamicGraphs[f].plotX.a, dynamicGraphs[f].plotY.a);
+                g->Plot(mglData(dynamicGraphs[f].plotX.a, points), mglData(dynamicGraphs[f].plotY.a, points));
             }
-
-            if (maxPower > 4000000)
-                maxPower = 4000000;
-            else if (maxPower < 1000000)
-                maxPower = 1000000;
-
-            mglGraph *g = dynamicGraphs[f].fftGraph;
-            mreal xvalues[4] = {512, 1024, 1536, 2048};
-            g->SetRanges(0, 2048, 0, maxPower);
-            g->SetTicksVal('x', mglData(4, xvalues), "\\125\n\\250\n\\375\n\\500");
-
-            g->Axis();
-            g->Label('x',"Hz",0);
-            g->Plot(dynamicGraphs[f].fft);
             if (f==0)
-                g->Puts(mglPoint(0.5,1.1),"FFT - Sensor 1","a");
+                g->Puts(mglPoint(0.5,1.1),"Raw Data - Sensor 1","a");
             else
-                g->Puts(mglPoint(0.5,1.1),"FFT - Sensor 2","a");
-            dynamicGraphs[f].fftWidget->setPixmap(QPixmap::fromImage(
-                  QImage(g->GetRGBA(), g->GetWidth(), g->GetHeight(), QImage::Format_RGBA8888)));
+                g->Puts(mglPoint(0.5,1.1),"Raw Data - Sensor 2","a");
+            publish(dynamicGraphs[f].frame, g);
+        }
 
+        // The spectrum averages about as many segments as fit in the history, and is fed with the new samples only
+        Welch &spectrum = dynamicGraphs[f].spectrum;
+        unsigned int segment = request.spectrumSegment;
+        unsigned int hop = segment - segment * request.spectrumOverlap / 100;
+        unsigned int averaged = graphDataCount > segment?(graphDataCount - segment) / hop + 1:1;
+        double sampleRate = 1000.0 / device->periodMs;
+        size_t first = filled - count;
+        if (spectrum.configure(segment, hop, averaged, request.spectrumWindow, sampleRate) ||
+                range.end - count != dynamicGraphs[f].spectrumSequence)
+        {
+            // Start over with the whole history if the settings changed or the stream has a gap.  The spectrogram keeps
+            // one spectrum per hop of the history.
+            spectrum.clear();
+            dynamicGraphs[f].spectrogram.configure(spectrum.bins(), graphDataCount / hop + 1);
+            dynamicGraphs[f].spectrogramValid = false;
+            first = 0;
+        }
+        dynamicGraphs[f].spectrumSequence = range.end;
+
+        // Every completed segment is a new column of the spectrogram, which is kept up to date even when not shown
+        unsigned int completed = spectrum.push(dynamicGraphs[f].data.a + first, filled - first);
+        if (completed > spectrum.segments())
+            completed = spectrum.segments();
+        unsigned int added = 0;
+        for (unsigned int age = completed; age-- > 0;)
+        {
+            // A segment that ended before the data at hand (which is at most a hop) has no known time, and is skipped
+            size_t ago = spectrum.segmentEnd(age);
+            if (ago >= filled)
+                continue;
+            if (dynamicGraphs[f].spectrogram.add(dynamicGraphs[f].timestamps.a[filled - 1 - ago], spectrum.periodogram(age)))
+                dynamicGraphs[f].spectrogramValid = false;
+            ++added;
         }
+
+        if (request.spectrogram)
+        {
+            updateSpectrogram(f, device, added);
+            continue;
+        }
+
+        // The spectrum is drawn again only when a new segment was added, or if its graph was resized
+        if (completed == 0 && !dynamicGraphs[f].fftFrame.resized())
+            continue;
+        if (spectrum.segments() == 0)
+            continue;
+
+        unsigned int bins = spectrum.bins();
+        if (dynamicGraphs[f].fft.GetNx() != (long)bins)
+            dynamicGraphs[f].fft.Create(bins);
+        spectrum.density(dynamicGraphs[f].fft.a);
+
+        // Show the top 100dB, in steps of 10dB
+        double maxPower = ceil(dynamicGraphs[f].fft.Maximal() / 10) * 10;
+        double minPower = floor(dynamicGraphs[f].fft.Minimal() / 10) * 10;
+        if (minPower < maxPower - 100)
+            minPower = maxPower - 100;
+        if (minPower >= maxPower)
+            minPower = maxPower - 10;
+
+        // Bin i is at i * sampleRate / segment Hz, up to the Nyquist frequency
+        double nyquist = sampleRate / 2;
+        g = dynamicGraphs[f].fftGraph;
+        mglData frequencies(bins);
+        frequencies.Fill(0, nyquist);
+        g->Clf();
+        g->SetRanges(0, nyquist, minPower, maxPower);
+        g->SetTicks('x', nyquist / 4, 0);
+
+        g->Axis();
+        g->Label('x',"Hz",0);
+        g->Label('y',"dB",0);
+        g->Plot(frequencies, dynamicGraphs[f].fft);
+        if (f==0)
+            g->Puts(mglPoint(0.5,1.1),"Power Spectral Density - Sensor 1","a");
+        else
+            g->Puts(mglPoint(0.5,1.1),"Power Spectral Density - Sensor 2","a");
+        publish(dynamicGraphs[f].fftFrame, g);
     }
 }
 
-void MainWindow::updateGraphIMU()
+void MainWindow::updateGraphIMU(Device *device, const RenderRequest &request)
 {
     for (int f = 0; f < FINGER_COUNT; ++f)
     {
-        imuGraphs[f].graphAccel->Clf();
-        imuGraphs[f].graphGyro->Clf();
+        if (fit(imuGraphs[f].graphAccel, imuGraphs[f].frameAccel))
+            imuGraphs[f].stripValid = false;
+        if (fit(imuGraphs[f].graphGyro, imuGraphs[f].frameGyro))
+            imuGraphs[f].stripValid = false;
+
+        // The gyroscope graph is reduced to the width of the accelerometer graph too; they are laid out the same
+        if (imuGraphs[f].plotX[0].GetNx() != 2 * imuGraphs[f].graphAccel->GetWidth())
+            for (int j = 0; j < 6; ++j)
+            {
+                imuGraphs[f].plotX[j].Create(2 * imuGraphs[f].graphAccel->GetWidth());
+                imuGraphs[f].plotY[j].Create(2 * imuGraphs[f].graphAccel->GetWidth());
+            }
     }
 
-    if (fingerData.empty())
+    if (device == NULL)
         return;
 
-    std::vector<Fingers> fd;
-    fingerData.extract(fd);
-
     for (int f = 0; f < FINGER_COUNT; ++f)
     {
-        int64_t oldestTime, newestTime;
         double maxAccel = 1, minAccel = -1, maxGyro = 1, minGyro = -1;
 
-        // Take acceleration and gyro data and store for plotting
+        // Look only at the data that arrived since the last update, and no more than the graph holds
         size_t graphDataCount = imuGraphs[f].dataAccel.GetNx();
         if (graphDataCount > imuGraphs[f].dataGyro.GetNx())
             graphDataCount = imuGraphs[f].dataGyro.GetNx();
-        size_t start = graphDataCount < fd.size()?fd.size() - graphDataCount:0;
-        size_t end = fd.size();
-
-        oldestTime = fd[start].timestamp;
-        newestTime = fd[end - 1].timestamp;
-        int64_t lastTimestamp = oldestTime - 1;
-        for (size_t i = start; i < end; ++i)
+        FingerHistory::Range range = device->fingerData.range(imuGraphs[f].nextSequence, graphDataCount);
+        size_t filled = imuGraphs[f].filled;
+        size_t count = range.size();
+        size_t drop = filled + count > graphDataCount?filled + count - graphDataCount:0;     // Old data to make room
+
+        // Shift the old acceleration and gyro data and append the new
+        filled -= drop;
+        memmove(imuGraphs[f].timestamps.a, imuGraphs[f].timestamps.a + drop, filled * sizeof *imuGraphs[f].timestamps.a);
+        for (int j = 0; j < 3; ++j)
         {
-            int64_t t = fd[i].timestamp;
-            // Again, for non-realtime operating systems because they may read multiple messages in the same millisecond
-            if (t <= lastTimestamp)
-                t = lastTimestamp + 1;
-            lastTimestamp = t;
+            mreal *accel = imuGraphs[f].dataAccel.a + j * graphDataCount;
+            mreal *gyro = imuGraphs[f].dataGyro.a + j * graphDataCount;
+            memmove(accel, accel + drop, filled * sizeof *accel);
+            memmove(gyro, gyro + drop, filled * sizeof *gyro);
+        }
+        RingSpan<int64_t> timestamps = device->fingerData.timestamps(range);
+        for (size_t i = 0; i < count; ++i)
+            imuGraphs[f].timestamps.a[filled + i] = timestamps[i] / 1e9;
+        for (int j = 0; j < 3; ++j)
+        {
+            RingSpan<int16_t> accel = device->fingerData.accelerometer(range, f, j);
+            RingSpan<int16_t> gyro = device->fingerData.gyroscope(range, f, j);
+            for (size_t i = 0; i < count; ++i)
+            {
+                imuGraphs[f].dataAccel.a[j * graphDataCount + filled + i] = accel[i];
+                imuGraphs[f].dataGyro.a[j * graphDataCount + filled + i] = gyro[i];
+            }
+        }
+        filled += count;
+        imuGraphs[f].filled = filled;
+        imuGraphs[f].nextSequence = range.end;
 
-            imuGraphs[f].timestamps.a[i - start] = t / 1000.0f;
+        // If the acquisition overwrote the data while it was being read, start over on the next update
+        if (!device->fingerData.intact(range))
+        {
+            imuGraphs[f].filled = 0;
+            imuGraphs[f].nextSequence = 0;
+            imuGraphs[f].stripValid = false;
+            continue;
+        }
+        if (filled == 0)
+            continue;
+
+        // When zoomed out, show the envelope of the long term history instead of the raw data
+        static const char *const axisColors[3] = {"b", "g", "r"};
+        int64_t span = request.imuSpan;
+        SummaryPlot accelSummary[3], gyroSummary[3];
+        bool summarized = span != 0;
+        for (int j = 0; j < 3 && summarized; ++j)
+            summarized = summaryData(device->summary, f * SUMMARY_CHANNELS_PER_FINGER + SUMMARY_ACCELEROMETER + j, span,
+                                     imuGraphs[f].graphAccel->GetWidth(), 1, accelSummary[j]) &&
+                         summaryData(device->summary, f * SUMMARY_CHANNELS_PER_FINGER + SUMMARY_GYROSCOPE + j, span,
+                                     imuGraphs[f].graphGyro->GetWidth(), 1, gyroSummary[j]);
+
+        // The recent history scrolls by, so with min/max decimation only the new samples need to be drawn
+        if (!summarized && request.decimation == DECIMATION_MIN_MAX)
+        {
+            updateStripIMU(f, device, count);
+            continue;
+        }
+        imuGraphs[f].stripValid = false;
+        imuGraphs[f].graphAccel->Clf();
+        imuGraphs[f].graphGyro->Clf();
 
+        double oldestTime, newestTime;
+        if (summarized)
+        {
+            oldestTime = accelSummary[0].time.a[0];
+            newestTime = accelSummary[0].time.a[accelSummary[0].time.GetNx() - 1];
             for (int j = 0; j < 3; ++j)
             {
-                int16_t a = fd[i].finger[f].accelerometer[j];
-                int16_t g = fd[i].finger[f].gyroscope[j];
-                imuGraphs[f].dataAccel.a[j * graphDataCount + i - start] = a;
-                imuGraphs[f].dataGyro.a[j * graphDataCount + i - start] = g;
+                if (accelSummary[j].max.Maximal() > maxAccel) maxAccel = accelSummary[j].max.Maximal();
+                if (accelSummary[j].min.Minimal() < minAccel) minAccel = accelSummary[j].min.Minimal();
+                if (gyroSummary[j].max.Maximal() > maxGyro) maxGyro = gyroSummary[j].max.Maximal();
+                if (gyroSummary[j].min.Minimal() < minGyro) minGyro = gyroSummary[j].min.Minimal();
+            }
+        }
+        else
+        {
+            oldestTime = imuGraphs[f].timestamps.a[0];
+            newestTime = imuGraphs[f].timestamps.a[filled - 1];
+            for (int j = 0; j < 3; ++j)
+                for (size_t i = 0; i < filled; ++i)
+                {
+                    mreal a = imuGraphs[f].dataAccel.a[j * graphDataCount + i];
+                    mreal g = imuGraphs[f].dataGyro.a[j * graphDataCount + i];
+
+                    if (a > maxAccel) maxAccel = a;
+                    if (a < minAccel) minAccel = a;
+                    if (g > maxGyro) maxGyro = g;
+                    if (g < minGyro) minGyro = g;
+                }
+        }
 
-                if (a > maxAccel) maxAccel = a;
-                if (a < minAccel) minAccel = a;
-                if (g > maxGyro) maxGyro = g;
-                if (g < minGyro) minGyro = g;
+        // Reduce the data to the width of the graphs, or without decimation, plot the whole history as is
+        size_t points[6];
+        const mreal *plotX[6], *plotY[6];
+        if (!summarized)
+        {
+            DecimationMethod method = request.decimation;
+            for (int j = 0; j < 6; ++j)
+            {
+                const mreal *data = (j < 3?imuGraphs[f].dataAccel.a:imuGraphs[f].dataGyro.a) + (j % 3) * graphDataCount;
+                if (method == DECIMATION_NONE)
+                {
+                    plotX[j] = imuGraphs[f].timestamps.a;
+                    plotY[j] = data;
+                    points[j] = filled;
+                    continue;
+                }
+                points[j] = decimate(method, imuGraphs[f].timestamps.a, data, filled, imuGraphs[f].graphAccel->GetWidth(),
+                                     imuGraphs[f].plotX[j].a, imuGraphs[f].plotY[j].a);
+                plotX[j] = imuGraphs[f].plotX[j].a;
+                plotY[j] = imuGraphs[f].plotY[j].a;
             }
         }
 
         mglGraph *g = imuGraphs[f].graphAccel;
-        g->SetRanges(oldestTime / 1000.0f, newestTime / 1000.0f, minAccel, maxAccel);
+        g->SetRanges(oldestTime, newestTime, minAccel, maxAccel);
 
         g->Axis();
         g->Label('x',"s",0);
         for (int j = 0; j < 3; ++j)
-            g->Plot(mglData(imuGraphs[f].timestamps.a, end - start), mglData(imuGraphs[f].dataAccel.a + j * graphDataCount, end - start));
+            if (summarized)
+                g->Region(accelSummary[j].time, accelSummary[j].min, accelSummary[j].max, axisColors[j]);
+            else
+                g->Plot(mglData(plotX[j], points[j]), mglData(plotY[j], points[j]));
 
         g->AddLegend("Ax","b");
         g->AddLegend("Ay","g");
@@ -340,16 +794,18 @@ void MainWindow::updateGraphIMU()
             g->Puts(mglPoint(0.5,1.1),"Accelerometers - Sensor 1","a");
         else
             g->Puts(mglPoint(0.5,1.1),"Accelerometers - Sensor 2","a");
-        imuGraphs[f].widgetAccel->setPixmap(QPixmap::fromImage(
-              QImage(g->GetRGBA(), g->GetWidth(), g->GetHeight(), QImage::Format_RGBA8888)));
+        publish(imuGraphs[f].frameAccel, g);
 
         g = imuGraphs[f].graphGyro;
-        g->SetRanges(oldestTime / 1000.0f, newestTime / 1000.0f, minGyro, maxGyro);
+        g->SetRanges(oldestTime, newestTime, minGyro, maxGyro);
 
         g->Axis();
         g->Label('x',"s",0);
         for (int j = 0; j < 3; ++j)
-            g->Plot(mglData(imuGraphs[f].timestamps.a, end - start), mglData(imuGraphs[f].dataGyro.a + j * graphDataCount, end - start));
+            if (summarized)
+                g->Region(gyroSummary[j].time, gyroSummary[j].min, gyroSummary[j].max, axisColors[j]);
+            else
+                g->Plot(mglData(plotX[3 + j], points[3 + j]), mglData(plotY[3 + j], points[3 + j]));
         g->AddLegend("Gx","b");
         g->AddLegend("Gy","g");
         g->AddLegend("Gz","r");
@@ -358,27 +814,196 @@ void MainWindow::updateGraphIMU()
             g->Puts(mglPoint(0.5,1.1),"Gyroscopes - Sensor 1","a");
         else
             g->Puts(mglPoint(0.5,1.1),"Gyroscopes - Sensor 2","a");
-        imuGraphs[f].widgetGyro->setPixmap(QPixmap::fromImage(
-              QImage(g->GetRGBA(), g->GetWidth(), g->GetHeight(), QImage::Format_RGBA8888)));
+        publish(imuGraphs[f].frameGyro, g);
     }
 }
 
+void MainWindow::updateStripDynamic(int f, Device *device, size_t count)
+{
+    DynamicGraph &graph = dynamicGraphs[f];
+    size_t filled = graph.filled;
+    size_t from = filled - count;
+
+    // The axes are drawn only once, with time relative to the newest sample.  The strip then starts with the whole history.
+    if (!graph.stripValid)
+    {
+        double window = graph.data.GetNx() * device->periodMs / 1000.0;
+        mglGraph *g = graph.graph;
+        g->Clf();
+        g->SetRanges(-window, 0, -1, 1);
+        g->Axis();
+        g->Label('y',"mV",0);
+        g->Label('x',"s",0);
+        if (f==0)
+            g->Puts(mglPoint(0.5,1.1),"Raw Data - Sensor 1","a");
+        else
+            g->Puts(mglPoint(0.5,1.1),"Raw Data - Sensor 2","a");
+        layoutStrip(graph.strip, g, window, -1, 1, 1);
+        graph.stripValid = true;
+        from = 0;
+    }
+
+    for (size_t i = from; i < filled; ++i)
+    {
+        double value = graph.data.a[i];
+        graph.strip.append(graph.timestamps.a[i], &value);
+    }
+    graph.frame.publish(graph.strip.compose(), graph.strip.width(), graph.strip.height());
+}
 
-void MainWindow::updateFFT()
+void MainWindow::updateSpectrogram(int f, Device *device, unsigned int added)
 {
-#if READ_DATA_PERIOD_MS == 1
-    for (int f = 0; f < FINGER_COUNT; ++f)
-        dynamicGraphs[f].shouldUpdateFFTGraph = true;
-#endif
+    DynamicGraph &graph = dynamicGraphs[f];
+    Spectrogram &spectrogram = graph.spectrogram;
+    StripChart &strip = graph.spectrogramStrip;
+    if (spectrogram.size() == 0)
+        return;
+
+    // Like the strips of the IMU, the color scale grows right away but is fit to the data only once per window
+    double window = graph.data.GetNx() * device->periodMs / 1000.0;
+    double newest = spectrogram.time(spectrogram.size() - 1);
+    if (newest - graph.spectrogramFitTime > window)
+    {
+        if (spectrogram.refit())
+            graph.spectrogramValid = false;
+        graph.spectrogramFitTime = newest;
+    }
+
+    // The axes and the color bar are drawn only once, and then the strip starts with all the kept spectra.  Otherwise
+    // only the new spectra are colored and added, and the rest scrolls.
+    size_t from = spectrogram.size() - (added < spectrogram.size()?added:spectrogram.size());
+    if (!graph.spectrogramValid)
+    {
+        double nyquist = 500.0 / device->periodMs;
+        mglGraph *g = graph.fftGraph;
+        g->Clf();
+        g->SetRanges(-window, 0, 0, nyquist);
+        g->SetRange('c', spectrogram.low(), spectrogram.high());
+        g->SetTicks('y', nyquist / 4, 0);
+        g->Axis();
+        g->Colorbar("{B,0}{b,0.17}{c,0.25}{y,0.35}{r,0.55}{R,0.85}>");
+        g->Label('y',"Hz",0);
+        g->Label('x',"s",0);
+        if (f==0)
+            g->Puts(mglPoint(0.5,1.1),"Spectrogram (dB) - Sensor 1","a");
+        else
+            g->Puts(mglPoint(0.5,1.1),"Spectrogram (dB) - Sensor 2","a");
+        layoutStrip(strip, g, window, 0, nyquist, 0);
+        graph.spectrogramValid = true;
+        from = 0;
+    }
+
+    std::vector<uint32_t> pixels(strip.rows());
+    if (!pixels.empty())
+        for (size_t i = from; i < spectrogram.size(); ++i)
+        {
+            spectrogram.color(spectrogram.spectrum(i), strip.rows(), &pixels[0]);
+            strip.appendColumn(spectrogram.time(i), &pixels[0]);
+        }
+    graph.fftFrame.publish(strip.compose(), strip.width(), strip.height());
 }
 
-void MainWindow::resetStaticBaseline()
+void MainWindow::updateStripIMU(int f, Device *device, size_t count)
 {
-    for (int f = 0; f < FINGER_COUNT; ++f)
+    IMUGraph &graph = imuGraphs[f];
+    size_t graphDataCount = graph.dataAccel.GetNx();
+    if (graphDataCount > graph.dataGyro.GetNx())
+        graphDataCount = graph.dataGyro.GetNx();
+    size_t filled = graph.filled;
+    size_t from = filled - count;
+    const mreal *accel = graph.dataAccel.a;
+    const mreal *gyro = graph.dataGyro.a;
+    double window = graph.timestamps.GetNx() * device->periodMs / 1000.0;
+    double newest = graph.timestamps.a[filled - 1];
+
+    // The value ranges grow as soon as new data falls outside them, but are fit to the data (which may shrink them)
+    // only once per window, so that the strips are rarely redrawn as a whole
+    bool refit = !graph.stripValid || newest - graph.stripFitTime > window;
+    for (int j = 0; j < 3 && !refit; ++j)
+        for (size_t i = from; i < filled && !refit; ++i)
+        {
+            mreal a = accel[j * graphDataCount + i];
+            mreal g = gyro[j * graphDataCount + i];
+            refit = a < graph.stripAccel.low() || a > graph.stripAccel.high() ||
+                    g < graph.stripGyro.low() || g > graph.stripGyro.high();
+        }
+
+    if (refit)
     {
-        staticGraphs[f].shouldResetBaseline = true;
-        staticGraphs[f].maxRange = 0;
+        double maxAccel = 1, minAccel = -1, maxGyro = 1, minGyro = -1;
+        for (int j = 0; j < 3; ++j)
+            for (size_t i = 0; i < filled; ++i)
+            {
+                mreal a = accel[j * graphDataCount + i];
+                mreal g = gyro[j * graphDataCount + i];
+
+                if (a > maxAccel) maxAccel = a;
+                if (a < minAccel) minAccel = a;
+                if (g > maxGyro) maxGyro = g;
+                if (g < minGyro) minGyro = g;
+            }
+
+        // Leave some room, so that the ranges don't change with every new extreme.  The current ranges are kept if they
+        // still hold the data and are not much larger than needed.
+        double low[2] = {minAccel - (maxAccel - minAccel) * 0.1, minGyro - (maxGyro - minGyro) * 0.1};
+        double high[2] = {maxAccel + (maxAccel - minAccel) * 0.1, maxGyro + (maxGyro - minGyro) * 0.1};
+        bool keep = graph.stripValid &&
+                    minAccel >= graph.stripAccel.low() && maxAccel <= graph.stripAccel.high() &&
+                    minGyro >= graph.stripGyro.low() && maxGyro <= graph.stripGyro.high() &&
+                    graph.stripAccel.high() - graph.stripAccel.low() < 2 * (high[0] - low[0]) &&
+                    graph.stripGyro.high() - graph.stripGyro.low() < 2 * (high[1] - low[1]);
+        graph.stripFitTime = newest;
+
+        if (!keep)
+        {
+            static const char *const legends[2][3] = {{"Ax", "Ay", "Az"}, {"Gx", "Gy", "Gz"}};
+            static const char *const titles[2][2] = {{"Accelerometers - Sensor 1", "Accelerometers - Sensor 2"},
+                                                     {"Gyroscopes - Sensor 1", "Gyroscopes - Sensor 2"}};
+            for (int k = 0; k < 2; ++k)
+            {
+                mglGraph *g = k == 0?graph.graphAccel:graph.graphGyro;
+                StripChart &strip = k == 0?graph.stripAccel:graph.stripGyro;
+                g->Clf();
+                g->SetRanges(-window, 0, low[k], high[k]);
+                g->Axis();
+                g->Label('x',"s",0);
+                g->AddLegend(legends[k][0],"b");
+                g->AddLegend(legends[k][1],"g");
+                g->AddLegend(legends[k][2],"r");
+                g->Legend(1.22,1.1,"6","size 6");
+                g->Puts(mglPoint(0.5,1.1),titles[k][f==0?0:1],"a");
+                layoutStrip(strip, g, window, low[k], high[k], 3);
+                strip.setColor(0, 0, 0, 255);
+                strip.setColor(1, 0, 255, 0);
+                strip.setColor(2, 255, 0, 0);
+            }
+            graph.stripValid = true;
+            from = 0;
+        }
+    }
+
+    for (size_t i = from; i < filled; ++i)
+    {
+        double a[3], g[3];
+        for (int j = 0; j < 3; ++j)
+        {
+            a[j] = accel[j * graphDataCount + i];
+            g[j] = gyro[j * graphDataCount + i];
+        }
+        graph.stripAccel.append(graph.timestamps.a[i], a);
+        graph.stripGyro.append(graph.timestamps.a[i], g);
     }
+    graph.frameAccel.publish(graph.stripAccel.compose(), graph.stripAccel.width(), graph.stripAccel.height());
+    graph.frameGyro.publish(graph.stripGyro.compose(), graph.stripGyro.width(), graph.stripGyro.height());
+}
+
+void MainWindow::resetStaticBaseline()
+{
+    // The baseline itself adapts continuously; this only starts it over, e.g. if the sensor was touched at startup
+    Device *device = shownDevice();
+    if (device != NULL && device->communicator != NULL)
+        device->communicator->resetBaseline();
+    pendingBaselineReset = true;
 }
 
 void MainWindow::showStaticRaw()
@@ -0,0 +1,200 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "heatmap.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HEATMAP_SSE2 1
+#endif
+
+#define COLOR_TABLE_SIZE 256
+
+// Color stops of the static sensor surface, with the colors of mathgl's B, b, c, y, r and R
+struct ColorStop
+{
+    float position;
+    float r, g, b;
+};
+
+static const ColorStop colorStops[] =
+{
+    {0.00f, 0.0f, 0.0f, 0.5f},
+    {0.17f, 0.0f, 0.0f, 1.0f},
+    {0.25f, 0.0f, 1.0f, 1.0f},
+    {0.35f, 1.0f, 1.0f, 0.0f},
+    {0.55f, 1.0f, 0.0f, 0.0f},
+    {0.85f, 0.5f, 0.0f, 0.0f},
+    {1.00f, 0.5f, 0.0f, 0.0f},
+};
+
+static uint32_t colorTable[COLOR_TABLE_SIZE];
+static bool colorTableReady = false;
+
+static void buildColorTable()
+{
+    size_t stop = 0;
+
+    for (int i = 0; i < COLOR_TABLE_SIZE; ++i)
+    {
+        float p = (float)i / (COLOR_TABLE_SIZE - 1);
+        while (stop + 2 < sizeof colorStops / sizeof *colorStops && p > colorStops[stop + 1].position)
+            ++stop;
+
+        const ColorStop &a = colorStops[stop];
+        const ColorStop &b = colorStops[stop + 1];
+        float t = (p - a.position) / (b.position - a.position);
+        if (t < 0) t = 0;
+        if (t > 1) t = 1;
+
+        // Stored as the bytes R, G, B, A, whatever the endianness
+        uint8_t rgba[4] = {
+            (uint8_t)((a.r + (b.r - a.r) * t) * 255 + 0.5f),
+            (uint8_t)((a.g + (b.g - a.g) * t) * 255 + 0.5f),
+            (uint8_t)((a.b + (b.b - a.b) * t) * 255 + 0.5f),
+            255,
+        };
+        memcpy(&colorTable[i], rgba, 4);
+    }
+
+    colorTableReady = true;
+}
+
+Heatmap::Heatmap():
+    imageWidth(0),
+    imageHeight(0),
+    plotLeft(0),
+    plotTop(0),
+    plotWidth(0),
+    plotHeight(0)
+{
+}
+
+void Heatmap::colorize(const float *values, int count, float low, float high, uint32_t *out)
+{
+    if (!colorTableReady)
+        buildColorTable();
+
+    float scale = high > low?(COLOR_TABLE_SIZE - 1) / (high - low):0;
+    for (int i = 0; i < count; ++i)
+    {
+        float v = (values[i] - low) * scale;
+        if (v < 0) v = 0;
+        if (v > COLOR_TABLE_SIZE - 1) v = COLOR_TABLE_SIZE - 1;
+        out[i] = colorTable[(int)v];
+    }
+}
+
+void Heatmap::setOverlay(const unsigned char *overlay, int width, int height, int left, int top, int right,
+                         int bottom)
+{
+    // Keep the plot inside the image
+    if (left < 0) left = 0;
+    if (top < 0) top = 0;
+    if (right > width) right = width;
+    if (bottom > height) bottom = height;
+
+    imageWidth = width;
+    imageHeight = height;
+    plotLeft = left;
+    plotTop = top;
+    plotWidth = right > left?right - left:0;
+    plotHeight = bottom > top?bottom - top:0;
+
+    // The overlay outside the plot stays as is, and the plot is overwritten by every render()
+    pixels.resize((size_t)width * height);
+    if (!pixels.empty())
+        memcpy(&pixels[0], overlay, pixels.size() * sizeof pixels[0]);
+}
+
+void Heatmap::render(const float *grid, int cols, int rows, float low, float high)
+{
+    // Note: the table is built on first use, by the (single) renderer thread
+    if (!colorTableReady)
+        buildColorTable();
+
+    int width = plotWidth;
+    int height = plotHeight;
+    if (width == 0 || height == 0)
+        return;
+
+    gridRows.resize((size_t)rows * width);
+    index.resize(width);
+
+    // Values are scaled so that low maps to the first color and high to the last
+    float scale = high > low?(COLOR_TABLE_SIZE - 1) / (high - low):0;
+    float offset = -low * scale;
+
+    // Interpolate every grid row horizontally, already scaled to color table indices
+    for (int r = 0; r < rows; ++r)
+    {
+        const float *g = grid + r * cols;
+        float *out = &gridRows[(size_t)r * width];
+        for (int x = 0; x < width; ++x)
+        {
+            float gx = width > 1?(float)x * (cols - 1) / (width - 1):0;
+            int c = (int)gx;
+            if (c >= cols - 1)
+                c = cols > 1?cols - 2:0;
+            float t = gx - c;
+            float v = cols > 1?g[c] + (g[c + 1] - g[c]) * t:g[0];
+            out[x] = v * scale + offset;
+        }
+    }
+
+    for (int y = 0; y < height; ++y)
+    {
+        float gy = height > 1?(float)y * (rows - 1) / (height - 1):0;
+        int r = (int)gy;
+        if (r >= rows - 1)
+            r = rows > 1?rows - 2:0;
+        float t = rows > 1?gy - r:0;
+        const float *above = &gridRows[(size_t)r * width];
+        const float *below = rows > 1?above + width:above;
+        int32_t *idx = &index[0];
+        int x = 0;
+
+#ifdef HEATMAP_SSE2
+        // Blend the two grid rows and convert to clamped indices, four pixels at a time
+        __m128 vt = _mm_set1_ps(t);
+        __m128 vmax = _mm_set1_ps(COLOR_TABLE_SIZE - 1);
+        __m128 vmin = _mm_setzero_ps();
+        for (; x + 4 <= width; x += 4)
+        {
+            __m128 a = _mm_loadu_ps(above + x);
+            __m128 b = _mm_loadu_ps(below + x);
+            __m128 v = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), vt));
+            v = _mm_min_ps(_mm_max_ps(v, vmin), vmax);
+            _mm_storeu_si128((__m128i *)(idx + x), _mm_cvttps_epi32(v));
+        }
+#endif
+        for (; x < width; ++x)
+        {
+            float v = above[x] + (below[x] - above[x]) * t;
+            if (v < 0) v = 0;
+            if (v > COLOR_TABLE_SIZE - 1) v = COLOR_TABLE_SIZE - 1;
+            idx[x] = (int32_t)v;
+        }
+
+        // Color lookup
+        uint32_t *out = &pixels[(size_t)(plotTop + y) * imageWidth + plotLeft];
+        for (x = 0; x < width; ++x)
+            out[x] = colorTable[idx[x]];
+    }
+}
@@ -0,0 +1,64 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include <vector>
+#include <stdint.h>
+
+/*
+ * A fast 2D rendering of a small grid of values, as an alternative to a 3D mathgl surface.  The grid is interpolated
+ * bilinearly to the size of the image and colored with the same color scale as the surface of the static sensors
+ * ({B,0}{b,0.17}{c,0.25}{y,0.35}{r,0.55}{R,0.85}), directly into an RGBA buffer.
+ *
+ * Interpolation is separable: every grid row is first interpolated horizontally to the width of the image (a few
+ * thousand values), and then every image row is a blend of two of those, which is a contiguous, vectorized loop.
+ *
+ * Like StripChart, the heatmap is drawn into the plot area of an overlay (title, color bar) that the caller renders
+ * only when the layout or the color scale changes.
+ */
+class Heatmap
+{
+public:
+    Heatmap();
+
+    // Lay out the heatmap: the overlay is a width x height RGBA image, in which the heatmap covers [left, right) x
+    // [top, bottom)
+    void setOverlay(const unsigned char *overlay, int width, int height, int left, int top, int right, int bottom);
+
+    // Render cols x rows values (row-major) into the plot area, with low and high the ends of the color scale
+    void render(const float *grid, int cols, int rows, float low, float high);
+
+    // Color count values with the same color scale, without interpolation
+    static void colorize(const float *values, int count, float low, float high, uint32_t *out);
+
+    // The image, RGBA8888
+    const unsigned char *rgba() const { return (const unsigned char *)&pixels[0]; }
+    int width() const { return imageWidth; }
+    int height() const { return imageHeight; }
+
+private:
+    int imageWidth, imageHeight;
+    int plotLeft, plotTop, plotWidth, plotHeight;
+    std::vector<uint32_t> pixels;   // the overlay with the heatmap drawn in
+    std::vector<float> gridRows;    // each grid row, interpolated to the width of the plot
+    std::vector<int32_t> index;     // one plot row, as indices in the color table
+};
+
+#endif // HEATMAP_H
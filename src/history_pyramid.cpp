@@ -0,0 +1,207 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "history_pyramid.h"
+
+// Number of buckets kept per level.  At 1KHz, that is 6 minutes at x10, 1 hour at x100 and 12 hours at x1000.
+static const size_t levelSizes[HistoryPyramid::LEVELS] = {36000, 36000, 43200};
+
+HistoryPyramid::Level::Level(size_t size, int channels):
+    sequencer(size),
+    time(size),
+    min(size * channels),
+    max(size * channels),
+    mean(size * channels)
+{
+}
+
+HistoryPyramid::HistoryPyramid(int channels_):
+    channels(channels_)
+{
+    for (int l = 0; l < LEVELS; ++l)
+    {
+        levels[l] = new Level(levelSizes[l], channels);
+
+        accumulators[l].count = 0;
+        accumulators[l].samples = 0;
+        accumulators[l].time = 0;
+        accumulators[l].min.resize(channels);
+        accumulators[l].max.resize(channels);
+        accumulators[l].sum.resize(channels);
+    }
+}
+
+HistoryPyramid::~HistoryPyramid()
+{
+    for (int l = 0; l < LEVELS; ++l)
+        delete levels[l];
+}
+
+void HistoryPyramid::push(int64_t timestamp, const int16_t *values)
+{
+    Accumulator &a = accumulators[0];
+
+    if (a.count == 0)
+    {
+        a.time = timestamp;
+        for (int c = 0; c < channels; ++c)
+        {
+            a.min[c] = a.max[c] = values[c];
+            a.sum[c] = values[c];
+        }
+    }
+    else
+        for (int c = 0; c < channels; ++c)
+        {
+            if (values[c] < a.min[c]) a.min[c] = values[c];
+            if (values[c] > a.max[c]) a.max[c] = values[c];
+            a.sum[c] += values[c];
+        }
+
+    ++a.samples;
+    if (++a.count == FACTOR)
+        finish(0);
+}
+
+void HistoryPyramid::finish(int level)
+{
+    Accumulator &a = accumulators[level];
+    Level &l = *levels[level];
+    size_t size = l.sequencer.capacity();
+
+    // Store the bucket
+    uint64_t h = l.sequencer.claim(1);
+    size_t at = h % size;
+    l.time[at] = a.time;
+    for (int c = 0; c < channels; ++c)
+    {
+        l.min[c * size + at] = a.min[c];
+        l.max[c * size + at] = a.max[c];
+        l.mean[c * size + at] = a.sum[c] / a.samples;
+    }
+    l.sequencer.publish(h + 1);
+
+    // Add it to the bucket of the next level
+    if (level + 1 < LEVELS)
+    {
+        Accumulator &p = accumulators[level + 1];
+
+        if (p.count == 0)
+        {
+            p.time = a.time;
+            p.min = a.min;
+            p.max = a.max;
+            p.sum = a.sum;
+        }
+        else
+            for (int c = 0; c < channels; ++c)
+            {
+                if (a.min[c] < p.min[c]) p.min[c] = a.min[c];
+                if (a.max[c] > p.max[c]) p.max[c] = a.max[c];
+                p.sum[c] += a.sum[c];
+            }
+
+        p.samples += a.samples;
+        if (++p.count == FACTOR)
+            finish(level + 1);
+    }
+
+    a.count = 0;
+    a.samples = 0;
+}
+
+int64_t HistoryPyramid::newest() const
+{
+    const Level &l = *levels[0];
+    uint64_t seq = l.sequencer.sequence();
+    if (seq == 0)
+        return -1;
+
+    int64_t t = l.time[(seq - 1) % l.sequencer.capacity()];
+    return l.sequencer.intactFrom() <= seq - 1?t:-1;
+}
+
+uint64_t HistoryPyramid::lowerBound(const Level &level, uint64_t from, uint64_t to, int64_t t) const
+{
+    size_t size = level.sequencer.capacity();
+
+    while (from < to)
+    {
+        uint64_t mid = from + (to - from) / 2;
+        if (level.time[mid % size] < t)
+            from = mid + 1;
+        else
+            to = mid;
+    }
+
+    return from;
+}
+
+int HistoryPyramid::chooseLevel(int64_t from, int64_t to, size_t maxPoints) const
+{
+    for (int l = 0; l < LEVELS; ++l)
+    {
+        const Level &level = *levels[l];
+        uint64_t first, end;
+        level.sequencer.available(0, 0, first, end);
+        if (first == end)
+            continue;
+
+        // A level covers the range if it goes back far enough, or if it has never lost anything
+        bool covers = first == 0 || level.time[first % level.sequencer.capacity()] <= from;
+        uint64_t points = lowerBound(level, first, end, to + 1) - lowerBound(level, first, end, from);
+        if (covers && points <= maxPoints)
+            return l;
+    }
+
+    return LEVELS - 1;
+}
+
+bool HistoryPyramid::query(int level, int channel, int64_t from, int64_t to, Series &series) const
+{
+    const Level &l = *levels[level];
+    size_t size = l.sequencer.capacity();
+    uint64_t first, end;
+    l.sequencer.available(0, 0, first, end);
+
+    // Include the bucket that contains from
+    uint64_t begin = lowerBound(l, first, end, from);
+    if (begin > first)
+        --begin;
+    end = lowerBound(l, begin, end, to + 1);
+
+    size_t n = end - begin;
+    series.time.resize(n);
+    series.min.resize(n);
+    series.max.resize(n);
+    series.mean.resize(n);
+
+    const int16_t *min = &l.min[channel * size];
+    const int16_t *max = &l.max[channel * size];
+    const float *mean = &l.mean[channel * size];
+    for (size_t i = 0; i < n; ++i)
+    {
+        size_t at = (begin + i) % size;
+        series.time[i] = l.time[at];
+        series.min[i] = min[at];
+        series.max[i] = max[at];
+        series.mean[i] = mean[at];
+    }
+
+    return l.sequencer.intactFrom() <= begin;
+}
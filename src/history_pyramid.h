@@ -0,0 +1,109 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HISTORY_PYRAMID_H
+#define HISTORY_PYRAMID_H
+
+#include <vector>
+#include "circular_buffer.h"
+
+/*
+ * Long term history of a few channels, summarized at several resolutions.  Every level keeps, for buckets of 10, 100
+ * and 1000 samples, the time of the first sample and the minimum, maximum and mean of every channel.  The levels are
+ * maintained incrementally as samples arrive (each bucket is computed from the 10 buckets of the level below), so
+ * nothing is ever rescanned, and each level is a fixed size ring, so memory stays bounded however long the
+ * acquisition runs.
+ *
+ * A query for a time range picks the finest level that still covers the range with no more points than asked for,
+ * so the cost of showing hours of data is proportional to the number of pixels, not the number of samples.
+ *
+ * There is a single writer and any number of lock-free readers, as in SpmcRing.
+ */
+class HistoryPyramid
+{
+public:
+    enum
+    {
+        LEVELS = 3,
+        FACTOR = 10,                // Each level summarizes FACTOR buckets of the level below
+    };
+
+    // The summary of one channel over a time range
+    struct Series
+    {
+        std::vector<int64_t> time;  // Time of the first sample of each bucket
+        std::vector<double> min, max, mean;
+    };
+
+    HistoryPyramid(int channels);
+    ~HistoryPyramid();
+
+    int channelCount() const { return channels; }
+
+    // Writer side, to be called from a single thread: one sample of every channel
+    void push(int64_t timestamp, const int16_t *values);
+
+    // Time of the newest finished bucket, or -1 if there is none yet
+    int64_t newest() const;
+
+    /*
+     * Choose the level to show [from, to] with at most maxPoints buckets.  The finest level that both covers the whole
+     * range and doesn't exceed maxPoints is chosen.  If none covers the range, the coarsest level is used.
+     */
+    int chooseLevel(int64_t from, int64_t to, size_t maxPoints) const;
+
+    // Summary of a channel over [from, to] at the given level.  Returns false if the writer overwrote it while reading.
+    bool query(int level, int channel, int64_t from, int64_t to, Series &series) const;
+
+private:
+    struct Level
+    {
+        Level(size_t size, int channels);
+
+        RingSequencer sequencer;
+        std::vector<int64_t> time;
+        // Every channel has its own column of capacity values, stored one after the other
+        std::vector<int16_t> min, max;
+        std::vector<float> mean;
+    };
+
+    // A bucket being filled
+    struct Accumulator
+    {
+        unsigned int count;         // Buckets of the level below (or samples) added so far
+        uint64_t samples;
+        int64_t time;
+        std::vector<int16_t> min, max;
+        std::vector<double> sum;
+    };
+
+    void finish(int level);
+
+    // First bucket of a level at or after time t, among the buckets [from, to)
+    uint64_t lowerBound(const Level &level, uint64_t from, uint64_t to, int64_t t) const;
+
+    int channels;
+    Level *levels[LEVELS];
+    Accumulator accumulators[LEVELS];
+
+    // Not copyable
+    HistoryPyramid(const HistoryPyramid &);
+    HistoryPyramid &operator=(const HistoryPyramid &);
+};
+
+#endif // HISTORY_PYRAMID_H
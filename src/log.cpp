@@ -19,32 +19,57 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "finger_data.h"
+#include "device.h"
+#include "communicator.h"
 #include <QFileDialog>
+#include <QFileInfo>
 
 void MainWindow::log()
 {
-    if (logFile == NULL)
+    if (!logging)
         return;
 
-    std::vector<Fingers> fd;
-    fingerDataForLog.extract(fd, true);
+    // Note: the setting can't change while logging, so the columns always match the header
+    bool logFiltered = ui->logFiltered->isChecked();
 
-    for (size_t i = 0; i < fd.size(); ++i)
+    for (size_t d = 0; d < devices.size(); ++d)
     {
-        fprintf(logFile, "%lld", (long long)fd[i].timestamp);
-        for (int f = 0; f < FINGER_COUNT; ++f)
-            for (int s = 0; s < FINGER_DYNAMIC_TACTILE_COUNT; ++s)
-                fprintf(logFile, "%s %d", csvSeparator, fd[i].finger[f].dynamicTactile[s]);
-        for (int f = 0; f < FINGER_COUNT; ++f)
-            for (int s = 0; s < FINGER_STATIC_TACTILE_COUNT; ++s)
-                fprintf(logFile, "%s %d", csvSeparator, fd[i].finger[f].staticTactile[s]);
-        for (int f = 0; f < FINGER_COUNT; ++f)
-            for (int s = 0; s < 3; ++s)
-                fprintf(logFile, "%s %d", csvSeparator, fd[i].finger[f].accelerometer[s]);
-        for (int f = 0; f < FINGER_COUNT; ++f)
-            for (int s = 0; s < 3; ++s)
-                fprintf(logFile, "%s %d", csvSeparator, fd[i].finger[f].gyroscope[s]);
-        fprintf(logFile, "\n");
+        FILE *logFile = devices[d]->logFile;
+        if (logFile == NULL)
+            continue;
+
+        std::vector<Fingers> fd;
+        devices[d]->logReader.extract(fd, true);
+
+        for (size_t i = 0; i < fd.size(); ++i)
+        {
+            fprintf(logFile, "%.3f", fd[i].timestamp / 1e6);
+            for (int f = 0; f < FINGER_COUNT; ++f)
+                for (int s = 0; s < FINGER_DYNAMIC_TACTILE_COUNT; ++s)
+                    fprintf(logFile, "%s %d", csvSeparator, fd[i].finger[f].dynamicTactile[s]);
+            for (int f = 0; f < FINGER_COUNT; ++f)
+                for (int s = 0; s < FINGER_STATIC_TACTILE_COUNT; ++s)
+                    fprintf(logFile, "%s %d", csvSeparator, fd[i].finger[f].staticTactile[s]);
+            for (int f = 0; f < FINGER_COUNT; ++f)
+                for (int s = 0; s < 3; ++s)
+                    fprintf(logFile, "%s %d", csvSeparator, fd[i].finger[f].accelerometer[s]);
+            for (int f = 0; f < FINGER_COUNT; ++f)
+                for (int s = 0; s < 3; ++s)
+                    fprintf(logFile, "%s %d", csvSeparator, fd[i].finger[f].gyroscope[s]);
+            if (logFiltered)
+            {
+                for (int f = 0; f < FINGER_COUNT; ++f)
+                    for (int s = 0; s < FINGER_DYNAMIC_TACTILE_COUNT; ++s)
+                        fprintf(logFile, "%s %d", csvSeparator, fd[i].finger[f].dynamicFiltered[s]);
+                for (int f = 0; f < FINGER_COUNT; ++f)
+                {
+                    for (int s = 0; s < FINGER_STATIC_TACTILE_COUNT; ++s)
+                        fprintf(logFile, "%s %d", csvSeparator, fd[i].finger[f].staticCompensated[s]);
+                    fprintf(logFile, "%s %d", csvSeparator, fd[i].finger[f].staticNoise);
+                }
+            }
+            fprintf(logFile, "\n");
+        }
     }
 }
 
@@ -64,7 +89,7 @@ void MainWindow::selectLogFile()
 
 void MainWindow::startStopLog()
 {
-    if (logFile)
+    if (logging)
         stopLog();
     else
         startLog();
@@ -72,18 +97,55 @@ void MainWindow::startStopLog()
 
 void MainWindow::startLog()
 {
-    logFile = fopen(ui->logPath->text().toUtf8().data(), "w");
-    if (logFile == NULL)
-    {
-        stopLog();
-        ui->logPath->setStyleSheet("background-color: rgb(255, 63, 63);");
+    logging = true;
+
+    for (size_t d = 0; d < devices.size() && logging; ++d)
+        startDeviceLog(devices[d]);
+
+    if (!logging)
         return;
-    }
 
     ui->logPath->setStyleSheet("");
     ui->log->setText("Stop Logging");
     ui->logPath->setEnabled(false);
     ui->logBrowse->setEnabled(false);
+    ui->logRaw->setEnabled(false);
+    ui->logFiltered->setEnabled(false);
+}
+
+QString MainWindow::deviceLogPath(Device *device, const char *suffix)
+{
+    QFileInfo info(ui->logPath->text());
+    QString path = info.path() + "/" + info.completeBaseName();
+
+    // With more than one board, every board other than the first gets its own file, e.g. finger_data_ttyACM1.csv
+    if (device != devices[0])
+    {
+        QString port = device->port.mid(device->port.lastIndexOf('/') + 1);
+        path += "_" + port;
+    }
+
+    if (suffix)
+        return path + "." + suffix;
+    return path + (info.suffix().isEmpty()?"":"." + info.suffix());
+}
+
+void MainWindow::startDeviceLog(Device *device)
+{
+    // Start with the data from now on
+    device->logReader.clear();
+
+    FILE *logFile = fopen(deviceLogPath(device, NULL).toUtf8().data(), "w");
+    if (logFile == NULL || (ui->logRaw->isChecked() &&
+                            !device->communicator->startRecording(deviceLogPath(device, "raw").toUtf8().data())))
+    {
+        if (logFile)
+            fclose(logFile);
+        stopLog();
+        ui->logPath->setStyleSheet("background-color: rgb(255, 63, 63);");
+        return;
+    }
+    device->logFile = logFile;
 
     fprintf(logFile, "Time(ms)");
     for (int f = 0; f < FINGER_COUNT; ++f)
@@ -96,18 +158,46 @@ void MainWindow::startLog()
         fprintf(logFile, "%s Ax%d%s Ay%d%s Az%d", csvSeparator, f, csvSeparator, f, csvSeparator, f);
     for (int f = 0; f < FINGER_COUNT; ++f)
         fprintf(logFile, "%s Gx%d%s Gy%d%s Gz%d", csvSeparator, f, csvSeparator, f, csvSeparator, f);
+
+    // The processed data (filtered dynamic, drift compensated static and its noise floor) goes last, so the log can
+    // still be replayed
+    if (ui->logFiltered->isChecked())
+    {
+        for (int f = 0; f < FINGER_COUNT; ++f)
+            for (int i = 0; i < FINGER_DYNAMIC_TACTILE_COUNT; ++i)
+                fprintf(logFile, "%s DF%d_%d", csvSeparator, i, f);
+        for (int f = 0; f < FINGER_COUNT; ++f)
+        {
+            for (int i = 0; i < FINGER_STATIC_TACTILE_COUNT; ++i)
+                fprintf(logFile, "%s SC%d_%d", csvSeparator, i, f);
+            fprintf(logFile, "%s SN_%d", csvSeparator, f);
+        }
+    }
     fprintf(logFile, "\n");
 }
 
 void MainWindow::stopLog()
 {
-    if (logFile)
-    {
-        fclose(logFile);
-        logFile = NULL;
-    }
+    logging = false;
+
+    for (size_t d = 0; d < devices.size(); ++d)
+        stopDeviceLog(devices[d]);
 
     ui->log->setText("Start Logging");
     ui->logPath->setEnabled(true);
     ui->logBrowse->setEnabled(true);
+    ui->logRaw->setEnabled(true);
+    ui->logFiltered->setEnabled(true);
+}
+
+void MainWindow::stopDeviceLog(Device *device)
+{
+    if (device->communicator)
+        device->communicator->stopRecording();
+
+    if (device->logFile)
+    {
+        fclose(device->logFile);
+        device->logFile = NULL;
+    }
 }
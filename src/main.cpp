@@ -18,14 +18,38 @@
 
 #include "mainwindow.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
 
 
 int main(int argc, char *argv[])
 {
+    // Startup is timed from here, to the first window and to the first sample
+    QElapsedTimer launch;
+    launch.start();
+
     QCoreApplication::addLibraryPath("./");
     QApplication a(argc, argv);
+
+    // Replaying from the command line allows profiling without a sensor, e.g. headless with -platform offscreen
+    QCommandLineParser parser;
+    QCommandLineOption replayOption("replay", "Replay a raw recording or CSV log.", "file");
+    QCommandLineOption speedOption("replay-speed", "Replay speed relative to real time, 0 for as fast as possible.",
+                                   "speed", "1");
+    QCommandLineOption startupOption("startup-times", "Print how long the window and the first sample took to show up.");
+    parser.addHelpOption();
+    parser.addOption(replayOption);
+    parser.addOption(speedOption);
+    parser.addOption(startupOption);
+    parser.process(a);
+
     MainWindow *w = new MainWindow;
+    w->timeStartup(launch, parser.isSet(startupOption));
     w->setWindowTitle("CoRo Sensor UI");
     w->show();
+
+    if (parser.isSet(replayOption))
+        w->replay(parser.value(replayOption), parser.value(speedOption).toDouble());
+
     return a.exec();
 }
@@ -18,16 +18,33 @@
 
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "device.h"
+#include "decimate.h"
+#include "port_scanner.h"
 #include <QWidgetAction>
 #include <QTimer>
+#include <QStandardPaths>
 #include <mgl2/qmathgl.h>
 
 MainWindow::MainWindow(QWidget *parent):
     QMainWindow(parent),
     ui(new Ui::MainWindow),
-    fingerData(4096),   // Note: 4096 is the FFT size, don't reduce!
-    fingerDataForLog(1024),
-    logFile(NULL),
+    nextDeviceId(0),
+    graphsDevice(-1),
+    renderer(NULL),
+    renderTicker(NULL),
+    pendingBaselineReset(false),
+    lastSequence(0),
+    lastRenderValid(false),
+    portScanner(NULL),
+    portScanRunning(false),
+    portScanPending(false),
+    portScanAutoconnect(false),
+    windowTimed(true),
+    sampleTimed(true),
+    windowShownMs(0),
+    printStartupTimes(false),
+    logging(false),
     csvSeparator(",")   // Because French programs sometimes take , as fractional point.
 {
     ui->setupUi(this);
@@ -45,28 +62,98 @@ MainWindow::MainWindow(QWidget *parent):
 
     ui->logPath->setText(FilePath);
 
+    ui->replaySpeed->setItemData(0, 1.0);
+    ui->replaySpeed->setItemData(1, 10.0);
+    ui->replaySpeed->setItemData(2, 100.0);
+    ui->replaySpeed->setItemData(3, 0.0);
+
+    static const unsigned int samplePeriods[] = {1, 2, 5, 10, 20, 50, 100};
+    for (int i = 0; i < ui->samplePeriod->count(); ++i)
+        ui->samplePeriod->setItemData(i, samplePeriods[i]);
+    static const unsigned int historyWindows[] = {4, 10, 30, 60};
+    for (int i = 0; i < ui->historyWindow->count(); ++i)
+        ui->historyWindow->setItemData(i, historyWindows[i]);
+    static const double renderBudgets[] = {0.1, 0.25, 0.5, 1};
+    for (int i = 0; i < ui->renderBudget->count(); ++i)
+        ui->renderBudget->setItemData(i, renderBudgets[i]);
+
+    ui->plotDecimation->setItemData(0, DECIMATION_MIN_MAX);
+    ui->plotDecimation->setItemData(1, DECIMATION_LTTB);
+    ui->plotDecimation->setItemData(2, DECIMATION_NONE);
+
+    static const unsigned int timeSpans[] = {0, 60, 600, 3600, 8 * 3600};
+    for (int i = 0; i < ui->dynamicTimeSpan->count(); ++i)
+    {
+        ui->dynamicTimeSpan->setItemData(i, timeSpans[i]);
+        ui->imuTimeSpan->setItemData(i, timeSpans[i]);
+    }
+
+    static const unsigned int spectrumSegments[] = {256, 512, 1024, 2048, 4096};
+    for (int i = 0; i < ui->spectrumSegment->count(); ++i)
+        ui->spectrumSegment->setItemData(i, spectrumSegments[i]);
+    static const unsigned int spectrumOverlaps[] = {0, 50, 75};
+    for (int i = 0; i < ui->spectrumOverlap->count(); ++i)
+        ui->spectrumOverlap->setItemData(i, spectrumOverlaps[i]);
+    ui->spectrumWindow->setItemData(0, SPECTRUM_HANN);
+    ui->spectrumWindow->setItemData(1, SPECTRUM_BLACKMAN);
+
+    static const double filterHighpasses[] = {0, 1, 5, 20};
+    for (int i = 0; i < ui->filterHighpass->count(); ++i)
+        ui->filterHighpass->setItemData(i, filterHighpasses[i]);
+    static const double filterNotches[] = {0, 50, 60};
+    for (int i = 0; i < ui->filterNotch->count(); ++i)
+        ui->filterNotch->setItemData(i, filterNotches[i]);
+    static const double filterLowpasses[] = {0, 100, 200, 400};
+    for (int i = 0; i < ui->filterLowpass->count(); ++i)
+        ui->filterLowpass->setItemData(i, filterLowpasses[i]);
+
+#ifndef Q_OS_LINUX
+    // The native serial backend is only implemented for Linux
+    ui->nativeSerial->hide();
+#endif
+
+    // Measured FFT plans are remembered across runs.  The renderer makes the plans, so this is done before it starts.
+    QString cache = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!cache.isEmpty() && QDir().mkpath(cache))
+        Welch::useWisdom(QDir(cache).filePath("fftw_wisdom").toLocal8Bit().data());
+
     initUiGraphs();
+    renderer = new GraphRenderer(this);
+    renderer->start();
+    portScanner = new PortScanner(this);
 
     // Connections
-    qRegisterMetaType<Fingers>("Fingers");
+    qRegisterMetaType<UsbLinkStats>("UsbLinkStats");
+    qRegisterMetaType<SampleClockStats>("SampleClockStats");
     connect(ui->refreshPorts, &QPushButton::pressed, this, &MainWindow::refreshPorts);
     connect(ui->connect, &QPushButton::pressed, this, &MainWindow::openCloseConnection);
+    connect(ui->replay, &QPushButton::pressed, this, &MainWindow::selectReplayFile);
+    connect(ui->availablePorts, &QComboBox::currentTextChanged, this, &MainWindow::updateConnectButton);
+    connect(ui->shownDevice, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &MainWindow::showDevice);
     connect(ui->staticBaselineReset, &QPushButton::pressed, this, &MainWindow::resetStaticBaseline);
     connect(ui->staticRawValues, &QCheckBox::toggled, this, &MainWindow::showStaticRaw);
+    connect(ui->filterHighpass, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &MainWindow::changeFilter);
+    connect(ui->filterNotch, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &MainWindow::changeFilter);
+    connect(ui->filterLowpass, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &MainWindow::changeFilter);
+    connect(ui->filterLowpassType, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &MainWindow::changeFilter);
     connect(ui->logBrowse, &QPushButton::pressed, this, &MainWindow::selectLogFile);
     connect(ui->log, &QPushButton::pressed, this, &MainWindow::startStopLog);
     connect(this, &MainWindow::closeConnectionSignal, this, &MainWindow::closeConnection);
     connect(this, &MainWindow::updateConnectionDataRateSignal, this, &MainWindow::updateConnectionDataRate);
+    connect(this, &MainWindow::updateConnectionLinkStatsSignal, this, &MainWindow::updateConnectionLinkStats);
+    connect(this, &MainWindow::updateConnectionClockSignal, this, &MainWindow::updateConnectionClock);
     connect(this, &MainWindow::newFingerDataSignal, this, &MainWindow::newFingerData);
+    connect(this, &MainWindow::contactEventsSignal, this, &MainWindow::contactEvents);
+    connect(this, &MainWindow::portsFoundSignal, this, &MainWindow::portsFound);
 
-    QTimer *slowUiTicker = new QTimer(this);
-    connect(slowUiTicker, &QTimer::timeout, this, &MainWindow::slowUiUpdate);
-    connect(slowUiTicker, &QTimer::timeout, this, &MainWindow::log);
-    slowUiTicker->start(20);
+    // The graphs are refreshed at a rate that adapts to their cost, but logging keeps a steady pace
+    renderTicker = new QTimer(this);
+    connect(renderTicker, &QTimer::timeout, this, &MainWindow::slowUiUpdate);
+    renderTicker->start(20);
 
-    QTimer *fftTicker = new QTimer(this);
-    connect(fftTicker, &QTimer::timeout, this, &MainWindow::updateFFT);
-    fftTicker->start(1000);
+    QTimer *logTicker = new QTimer(this);
+    connect(logTicker, &QTimer::timeout, this, &MainWindow::log);
+    logTicker->start(20);
 
     connectionClosed("Not connected");
     refreshPortsAutoconnect(true);
@@ -76,15 +163,74 @@ MainWindow::MainWindow(QWidget *parent):
 
 MainWindow::~MainWindow()
 {
+    // Stop rendering before the graphs and devices go away
+    delete renderer;
+    delete portScanner;
+
+    while (!devices.empty())
+        closeDevice(devices.back());
+
     delete ui;
 }
 
-void MainWindow::newFingerData(Fingers f)
+void MainWindow::newFingerData(int device, quint64 sequence)
 {
-    // Replicate data for users
+    Device *d = findDevice(device);
+    if (d == NULL)
+        return;
+
+    // The data is already in the device buffers, only remember how far it goes
+    d->dataSequence = sequence;
+
+    if (!sampleTimed)
+    {
+        sampleTimed = true;
+        qint64 ms = launchTimer.elapsed();
+        if (printStartupTimes)
+            fprintf(stderr, "First sample %lld ms after launch\n", (long long)ms);
+        ui->statusBar->showMessage(QString().asprintf("Started in %lld ms, first sample after %lld ms",
+                                                      (long long)windowShownMs, (long long)ms), 10000);
+    }
+}
 
-    // Persistent data used for plotting
-    fingerData.push(f);
-    // Consumed data used for logging
-    fingerDataForLog.push(f);
+void MainWindow::contactEvents(int device)
+{
+    Device *d = findDevice(device);
+    if (d == NULL)
+        return;
+
+    std::vector<ContactEvent> events;
+    d->contactReader.extract(events, true);
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        d->contact[events[i].finger] = events[i].onset;
+        d->contactLatencyLast = events[i].latency;
+        if (events[i].latency > d->contactLatencyMax)
+            d->contactLatencyMax = events[i].latency;
+    }
+
+    if (d == shownDevice())
+        updateContactStatus();
+}
+
+void MainWindow::timeStartup(const QElapsedTimer &launch, bool printTimes)
+{
+    launchTimer = launch;
+    printStartupTimes = printTimes;
+    windowTimed = false;
+    sampleTimed = false;
+}
+
+void MainWindow::paintEvent(QPaintEvent *event)
+{
+    QMainWindow::paintEvent(event);
+
+    if (!windowTimed)
+    {
+        windowTimed = true;
+        windowShownMs = launchTimer.elapsed();
+        if (printStartupTimes)
+            fprintf(stderr, "Window shown %lld ms after launch\n", (long long)windowShownMs);
+        ui->statusBar->showMessage(QString().asprintf("Started in %lld ms", (long long)windowShownMs), 10000);
+    }
 }
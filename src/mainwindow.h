@@ -23,17 +23,26 @@
 #include <QLabel>
 #include <stdio.h>
 #include <mgl2/qt.h>
-#include <fftw3.h>
 #include <QDir>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <vector>
 #include "circular_buffer.h"
 #include "finger_data.h"
+#include "usb_framer.h"
+#include "sample_clock.h"
+#include "graph_renderer.h"
+#include "heatmap.h"
+#include "plot_widget.h"
+#include "strip_chart.h"
+#include "spectrogram.h"
+#include "filter.h"
 
 namespace Ui {
 class MainWindow;
 }
 
-#define READ_DATA_PERIOD_MS 1
-
 class MainWindow: public QMainWindow
 {
     Q_OBJECT
@@ -41,84 +50,167 @@ public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
 
+    // Play back a raw recording or a CSV log as if it was a connected board.  Speed 0 is as fast as possible.
+    void replay(const QString &path, double speed);
+
+    // Render the graphs of one frame; called on the renderer thread.  Returns false if nothing needed redrawing.
+    bool renderGraphs(const RenderRequest &request);
+
+    // Report how long it took from launch until the window was first painted and until the first sample arrived, in
+    // the status bar and optionally on stderr
+    void timeStartup(const QElapsedTimer &launch, bool printTimes);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
 private slots:
     void openCloseConnection();
+    void selectReplayFile();
     void refreshPorts();
-    void updateConnectionDataRate(unsigned int bs);
-    void newFingerData(Fingers f);
+    void updateConnectButton();
+    void closeConnection(int device);
+    void updateConnectionDataRate(int device, unsigned int bs);
+    void updateConnectionLinkStats(int device, UsbLinkStats stats);
+    void updateConnectionClock(int device, SampleClockStats stats);
+    void showDevice();
+    void portsFound(QStringList ports, QStringList descriptions, bool allowAutoconnect);
+    void newFingerData(int device, quint64 sequence);
+    void contactEvents(int device);
     void slowUiUpdate();
-    void updateFFT();
     void resetStaticBaseline();
     void showStaticRaw();
+    void changeFilter();
     void log();
     void selectLogFile();
     void startStopLog();
 
 signals:
-    void closeConnectionSignal(const char *status);
-    void updateConnectionDataRateSignal(unsigned int bs);
-    void newFingerDataSignal(Fingers f);
+    void closeConnectionSignal(int device);
+    void updateConnectionDataRateSignal(int device, unsigned int bs);
+    void updateConnectionLinkStatsSignal(int device, UsbLinkStats stats);
+    void updateConnectionClockSignal(int device, SampleClockStats stats);
+    void newFingerDataSignal(int device, quint64 sequence);
+    void contactEventsSignal(int device);
+    void portsFoundSignal(QStringList ports, QStringList descriptions, bool allowAutoconnect);
 
 private:
     void refreshPortsAutoconnect(bool allowAutoconnect);
-    void openConnection();
-    void closeConnection();
+    QString selectedPort();
+    void openConnection(const QString &port);
+    void openDevice(const QString &port, class SerialLink *link, unsigned int periodMs);
+    void closeDevice(struct Device *device);
+    struct Device *findDevice(int id);
+    struct Device *findDevice(const QString &port);
+    struct Device *shownDevice();
+
+    FilterSettings filterSettings();
 
     void connectionFailed(const char *status);
     void connectionClosed(const char *status);
-    void connectionOpened(const char *status);
+    void connectionOpened();
+    void updateConnectionStatus();
+    void updateContactStatus();
 
     void initUiGraphs();
-    void updateGraphs();
-    void updateGraphStatic();
-    void updateGraphDynamic();
-    void updateGraphIMU();
+    void createGraphs(int tab);
+    void showFrames();
+    void configureGraphs(struct Device *device);
+    bool framesResized(int tab);
+    void updateGraphStatic(struct Device *device, const RenderRequest &request);
+    void updateGraphDynamic(struct Device *device, const RenderRequest &request);
+    void updateGraphIMU(struct Device *device, const RenderRequest &request);
+    void updateStripDynamic(int f, struct Device *device, size_t count);
+    void updateStripIMU(int f, struct Device *device, size_t count);
+    void updateSpectrogram(int f, struct Device *device, unsigned int added);
 
     void startLog();
     void stopLog();
+    QString deviceLogPath(struct Device *device, const char *suffix);
+    void startDeviceLog(struct Device *device);
+    void stopDeviceLog(struct Device *device);
 
 private:
     Ui::MainWindow *ui;
 
-    // Communication and data gathering
-    SafeCircularBuffer<Fingers> fingerData, fingerDataForLog;
-    class Communicator *communicator;
+    // Communication and data gathering, one per connected sensor board.  The list is only changed by the GUI thread,
+    // and then while holding devicesMutex, so the renderer can safely use the devices while holding it.
+    std::vector<struct Device *> devices;
+    QMutex devicesMutex;
+    int nextDeviceId;
 
-    // Graphics
+    // Graphics.  The graphs belong to the renderer thread, except for the widgets, and the frames which are shared.
     struct StaticGraph
     {
         mglData data;
         mglGraph *graph;
-        QLabel *widget;
-
-        bool shouldResetBaseline;
-        uint16_t baseline[FINGER_STATIC_TACTILE_COUNT];
-        unsigned int maxRange;
+        mglGraph *heatmapGraph;     // title and color bar of the heatmap
+        PlotWidget *widget;
+        FrameBuffer frame;
+        Heatmap heatmap;
+        double heatmapHigh;         // top of the color scale the heatmap was laid out for, 0 if not yet
+
+        double maxRange;            // top of the color scale, which follows the peaks
+        int64_t rangeTime;          // timestamp of the sample maxRange was last updated with
     };
     struct DynamicGraph
     {
         mglData data, fft, timestamps;
         mglGraph *graph, *fftGraph;
-        QLabel *widget, *fftWidget;
-
-        bool shouldUpdateFFTGraph;
-        double *fftIn;
-        fftw_complex *fftOut;
-        fftw_plan fftPlan;
+        PlotWidget *widget, *fftWidget;
+        FrameBuffer frame, fftFrame;
+
+        uint64_t nextSequence;      // First sample not yet in data
+        size_t filled;              // How much of data is in use
+        mglData plotX, plotY;       // data reduced to the width of the graph
+        StripChart strip;           // the recent history, drawn incrementally
+        bool stripValid;
+
+        Welch spectrum;             // fed with the new data, a segment at a time
+        uint64_t spectrumSequence;  // the sample the spectrum expects next, to notice gaps
+        Spectrogram spectrogram;    // the spectra of the segments in the history, oldest first
+        StripChart spectrogramStrip;
+        bool spectrogramValid;
+        double spectrogramFitTime;  // when the color scale was last fit to the spectrogram
     };
     struct IMUGraph
     {
         mglData dataAccel, dataGyro, timestamps;
         mglGraph *graphAccel, *graphGyro;
-        QLabel *widgetAccel, *widgetGyro;
+        PlotWidget *widgetAccel, *widgetGyro;
+        FrameBuffer frameAccel, frameGyro;
+
+        uint64_t nextSequence;
+        size_t filled;
+        mglData plotX[6], plotY[6]; // accelerometer then gyroscope axes, reduced to the width of the graph
+        StripChart stripAccel, stripGyro;
+        bool stripValid;
+        double stripFitTime;        // when the value ranges of the strips were last fit to the data
     };
 
     StaticGraph staticGraphs[FINGER_COUNT];
     DynamicGraph dynamicGraphs[FINGER_COUNT];
     IMUGraph imuGraphs[FINGER_COUNT];
+    int graphsDevice;                   // the device the graphs are currently sized for, or -1
+    GraphRenderer *renderer;
+    QTimer *renderTicker;
+    bool pendingBaselineReset;          // one-time action for the next request to the renderer
+    RenderRequest lastRequest;          // what was last rendered, to skip frames where nothing changed
+    uint64_t lastSequence;
+    bool lastRenderValid;
     QString FilePath;
 
-    FILE *logFile;
+    // Listing of the serial ports, which is done on another thread
+    class PortScanner *portScanner;
+    bool portScanRunning;
+    bool portScanPending;               // the ports should be listed again once the current scan is done
+    bool portScanAutoconnect;
+
+    QElapsedTimer launchTimer;          // started when the program was launched, until startup is reported
+    bool windowTimed, sampleTimed;
+    qint64 windowShownMs;
+    bool printStartupTimes;
+
+    bool logging;
     const char *csvSeparator;
 };
 
@@ -0,0 +1,79 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "plot_widget.h"
+#include <QPainter>
+
+PlotWidget::PlotWidget(FrameBuffer *frame_, int width, int height, QWidget *parent):
+    QWidget(parent),
+    frame(frame_),
+    hint(width, height),
+    ratio(1)
+{
+    // The frames cover the whole widget
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+}
+
+void PlotWidget::refresh()
+{
+    if (frame->take(image))
+        update();
+}
+
+void PlotWidget::requestSize()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+    ratio = devicePixelRatioF();
+#else
+    ratio = devicePixelRatio();
+#endif
+    QSize size = this->size() * ratio;
+    if (size == requested)
+        return;
+
+    requested = size;
+    frame->resize(size);
+}
+
+void PlotWidget::resizeEvent(QResizeEvent *)
+{
+    requestSize();
+}
+
+void PlotWidget::paintEvent(QPaintEvent *)
+{
+    // The device pixel ratio changes if the window is moved to another screen, which doesn't resize the widget
+    requestSize();
+
+    QPainter painter(this);
+    if (image.isNull())
+    {
+        painter.fillRect(rect(), Qt::white);
+        return;
+    }
+
+    // Until the renderer catches up with a resize, stretch the frame to the widget
+    if (image.size() == requested)
+    {
+        image.setDevicePixelRatio(ratio);
+        painter.drawImage(0, 0, image);
+    }
+    else
+        painter.drawImage(rect(), image);
+}
@@ -0,0 +1,56 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PLOT_WIDGET_H
+#define PLOT_WIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include "graph_renderer.h"
+
+/*
+ * Shows the frames of a graph.  The newest frame is taken from the frame buffer by swapping images, and painted as is
+ * in paintEvent, which avoids the QPixmap conversion and the scaling of a QLabel.  The size of the widget, in device
+ * pixels, is given back to the frame buffer so that the renderer draws the next frames at exactly that size.
+ */
+class PlotWidget: public QWidget
+{
+public:
+    PlotWidget(FrameBuffer *frame_, int width, int height, QWidget *parent = 0);
+
+    // Show the newest frame, if there is one
+    void refresh();
+
+    QSize sizeHint() const { return hint; }
+    QSize minimumSizeHint() const { return QSize(100, 50); }
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
+
+private:
+    void requestSize();
+
+    FrameBuffer *frame;
+    QImage image;
+    QSize hint;
+    QSize requested;                // size of the widget in device pixels, as given to the frame buffer
+    qreal ratio;
+};
+
+#endif // PLOT_WIDGET_H
@@ -0,0 +1,52 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "port_scanner.h"
+#include <QSerialPortInfo>
+
+PortScanner::PortScanner(MainWindow *w_):
+    w(w_),
+    autoconnect(false)
+{
+}
+
+PortScanner::~PortScanner()
+{
+    wait();
+}
+
+void PortScanner::scan(bool allowAutoconnect)
+{
+    // The previous scan may have sent its result but not yet returned from run()
+    wait();
+
+    autoconnect = allowAutoconnect;
+    start();
+}
+
+void PortScanner::run()
+{
+    QStringList ports, descriptions;
+    foreach (const QSerialPortInfo &info, QSerialPortInfo::availablePorts())
+    {
+        ports.append(info.portName());
+        descriptions.append(info.description());
+    }
+
+    emit w->portsFoundSignal(ports, descriptions, autoconnect);
+}
@@ -0,0 +1,44 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PORT_SCANNER_H
+#define PORT_SCANNER_H
+
+#include "mainwindow.h"
+#include <QThread>
+
+/*
+ * Lists the serial ports on its own thread, since that can block for a long time (for example on Windows, or with
+ * many USB devices).  The result is sent to the GUI with portsFoundSignal.
+ */
+class PortScanner: public QThread
+{
+public:
+    PortScanner(MainWindow *w_);
+    ~PortScanner();
+
+    // Start listing the ports; must not be called before the previous scan has sent its result
+    void scan(bool allowAutoconnect);
+    void run();
+
+private:
+    MainWindow *w;
+    bool autoconnect;
+};
+
+#endif // PORT_SCANNER_H
@@ -0,0 +1,275 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "replay.h"
+#include "finger_data.h"
+#include "usb_protocol.h"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+bool RawRecorder::open(const char *path, uint32_t periodMs)
+{
+    close();
+
+    file = fopen(path, "wb");
+    if (file == NULL)
+        return false;
+
+    fwrite(RAW_RECORDING_MAGIC, 1, strlen(RAW_RECORDING_MAGIC), file);
+    fwrite(&periodMs, sizeof periodMs, 1, file);
+
+    return true;
+}
+
+void RawRecorder::close()
+{
+    if (file)
+        fclose(file);
+    file = NULL;
+}
+
+void RawRecorder::record(int64_t time, const char *data, uint32_t size)
+{
+    fwrite(&time, sizeof time, 1, file);
+    fwrite(&size, sizeof size, 1, file);
+    fwrite(data, 1, size, file);
+}
+
+ReplayLink::ReplayLink(const char *path, double speed_):
+    csv(false), speed(speed_), recordedPeriodMs(0), replayError(QSerialPort::NoError),
+    pendingTime(0), hasPending(false), firstTime(-1), virtualTime(0), readWallTime(0), wokenUp(false)
+{
+    char magic[sizeof RAW_RECORDING_MAGIC] = {0};
+
+    file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        replayError = QSerialPort::DeviceNotFoundError;
+        return;
+    }
+
+    // Anything that is not a raw recording is taken to be a CSV log
+    if (fread(magic, 1, strlen(RAW_RECORDING_MAGIC), file) != strlen(RAW_RECORDING_MAGIC))
+        csv = true;
+    else if (strcmp(magic, RAW_RECORDING_MAGIC) == 0)
+    {
+        uint32_t period;
+        if (fread(&period, sizeof period, 1, file) == 1)
+            recordedPeriodMs = period;
+    }
+    else if (strcmp(magic, RAW_RECORDING_MAGIC_V1) != 0)
+        csv = true;
+
+    if (csv)
+    {
+        rewind(file);
+        detectCsvPeriod();
+    }
+}
+
+ReplayLink::~ReplayLink()
+{
+    if (file)
+        fclose(file);
+}
+
+bool ReplayLink::readRawRecord()
+{
+    uint32_t size;
+
+    if (fread(&pendingTime, sizeof pendingTime, 1, file) != 1 || fread(&size, sizeof size, 1, file) != 1)
+        return false;
+
+    pending.resize(size);
+    return size == 0 || fread(pending.data(), 1, size, file) == size;
+}
+
+static void appendPacket(std::vector<char> &out, UsbPacket *packet)
+{
+    size_t size = usbFinalizePacket(packet);
+    out.insert(out.end(), (char *)packet, (char *)packet + size);
+}
+
+bool ReplayLink::readCsvRecord()
+{
+    // Columns of the log: time, dynamic, static, accelerometer and gyroscope values of every finger.  See startLog().
+    enum
+    {
+        DYNAMIC_COLUMN = 1,
+        STATIC_COLUMN = DYNAMIC_COLUMN + FINGER_COUNT * FINGER_DYNAMIC_TACTILE_COUNT,
+        ACCEL_COLUMN = STATIC_COLUMN + FINGER_COUNT * FINGER_STATIC_TACTILE_COUNT,
+        GYRO_COLUMN = ACCEL_COLUMN + FINGER_COUNT * 3,
+        COLUMN_COUNT = GYRO_COLUMN + FINGER_COUNT * 3,
+    };
+
+    char line[4096];
+    double values[COLUMN_COUNT];
+
+    while (fgets(line, sizeof line, file))
+    {
+        // Parse the numbers, skipping the header and any incomplete lines
+        char *p = line;
+        int count = 0;
+        for (; count < COLUMN_COUNT; ++count)
+        {
+            char *end;
+            values[count] = strtod(p, &end);
+            if (end == p)
+                break;
+            p = end + strspn(end, ", ;\t");
+        }
+        if (count < COLUMN_COUNT)
+            continue;
+
+        pendingTime = (int64_t)(values[0] * 1000000);
+        pending.clear();
+
+        // Turn the values back into packets as the firmware would send them, with the dynamic data last as it marks
+        // the end of a set
+        UsbPacket packet;
+        uint16_t v[FINGER_STATIC_TACTILE_COUNT];
+
+        for (int f = 0; f < FINGER_COUNT; ++f)
+        {
+            packet.command = USB_COMMAND_AUTOSEND_SENSORS;
+            packet.data_length = 0;
+            for (int i = 0; i < FINGER_STATIC_TACTILE_COUNT; ++i)
+                v[i] = (uint16_t)values[STATIC_COLUMN + f * FINGER_STATIC_TACTILE_COUNT + i];
+            usbAppendSensor(&packet, USB_SENSOR_TYPE_STATIC_TACTILE, f, v, FINGER_STATIC_TACTILE_COUNT);
+            appendPacket(pending, &packet);
+        }
+
+        packet.command = USB_COMMAND_AUTOSEND_SENSORS;
+        packet.data_length = 0;
+        for (int f = 0; f < FINGER_COUNT; ++f)
+        {
+            for (int i = 0; i < 3; ++i)
+                v[i] = (uint16_t)(int16_t)values[ACCEL_COLUMN + f * 3 + i];
+            usbAppendSensor(&packet, USB_SENSOR_TYPE_ACCELEROMETER, f, v, 3);
+            for (int i = 0; i < 3; ++i)
+                v[i] = (uint16_t)(int16_t)values[GYRO_COLUMN + f * 3 + i];
+            usbAppendSensor(&packet, USB_SENSOR_TYPE_GYROSCOPE, f, v, 3);
+            for (int i = 0; i < FINGER_DYNAMIC_TACTILE_COUNT; ++i)
+                v[i] = (uint16_t)(int16_t)values[DYNAMIC_COLUMN + f * FINGER_DYNAMIC_TACTILE_COUNT + i];
+            usbAppendSensor(&packet, USB_SENSOR_TYPE_DYNAMIC_TACTILE, f, v, FINGER_DYNAMIC_TACTILE_COUNT);
+        }
+        appendPacket(pending, &packet);
+
+        return true;
+    }
+
+    return false;
+}
+
+void ReplayLink::detectCsvPeriod()
+{
+    // The time column of the log is the sample clock, so the period is the step between rows.  The median of the
+    // first steps is taken so a gap from lost data doesn't throw it off.
+    enum { STEP_COUNT = 32 };
+
+    char line[4096];
+    double steps[STEP_COUNT];
+    double last = 0;
+    bool hasLast = false;
+    int count = 0;
+
+    while (count < STEP_COUNT && fgets(line, sizeof line, file))
+    {
+        char *end;
+        double time = strtod(line, &end);
+        if (end == line)
+            continue;
+
+        if (hasLast && time > last)
+            steps[count++] = time - last;
+        last = time;
+        hasLast = true;
+    }
+
+    rewind(file);
+
+    if (count == 0)
+        return;
+
+    std::sort(steps, steps + count);
+    double step = steps[count / 2];
+    if (step >= 0.5)
+        recordedPeriodMs = (unsigned int)(step + 0.5);
+}
+
+bool ReplayLink::waitFor(int64_t time)
+{
+    if (firstTime < 0)
+        firstTime = time;
+
+    if (speed <= 0)
+        return true;
+
+    int64_t wallTime = (int64_t)((time - firstTime) / speed);
+
+    QMutexLocker locker(&wakeMutex);
+    while (!wokenUp)
+    {
+        // Waits are in ms, so anything sooner than that is given out right away.  The replay still keeps pace on
+        // average, since the target time is absolute.
+        int64_t remaining = wallTime - clock.nsecsElapsed();
+        if (remaining < 1000000)
+            return true;
+
+        wakeCondition.wait(&wakeMutex, remaining / 1000000);
+    }
+
+    wokenUp = false;
+    return false;
+}
+
+int64_t ReplayLink::read(std::vector<char> &buffer)
+{
+    if (file == NULL)
+        return -1;
+
+    if (!hasPending)
+    {
+        hasPending = csv?readCsvRecord():readRawRecord();
+
+        // End of recording
+        if (!hasPending)
+            return -1;
+    }
+
+    if (!waitFor(pendingTime))
+        return 0;
+
+    if (buffer.size() < pending.size())
+        buffer.resize(pending.size());
+    memcpy(buffer.data(), pending.data(), pending.size());
+
+    virtualTime = pendingTime;
+    readWallTime = clock.nsecsElapsed();
+    hasPending = false;
+
+    return pending.size();
+}
+
+void ReplayLink::wakeUp()
+{
+    QMutexLocker locker(&wakeMutex);
+    wokenUp = true;
+    wakeCondition.wakeAll();
+}
@@ -0,0 +1,101 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "serial_link.h"
+#include <QMutex>
+#include <QWaitCondition>
+#include <stdio.h>
+
+/*
+ * Raw recordings start with RAW_RECORDING_MAGIC and the sample period in ms (uint32_t), followed by one record per chunk
+ * read from the port: the time of the read in ns (int64_t), the size of the chunk (uint32_t) and the bytes themselves,
+ * in host byte order.  Recordings with RAW_RECORDING_MAGIC_V1 are the same, but without the sample period.
+ */
+#define RAW_RECORDING_MAGIC "CORORAW2"
+#define RAW_RECORDING_MAGIC_V1 "CORORAW1"
+
+class RawRecorder
+{
+public:
+    RawRecorder(): file(NULL) {}
+    ~RawRecorder() { close(); }
+
+    bool open(const char *path, uint32_t periodMs);
+    void close();
+    bool isOpen() const { return file != NULL; }
+
+    void record(int64_t time, const char *data, uint32_t size);
+
+private:
+    FILE *file;
+};
+
+/*
+ * Plays back a raw recording, or a CSV log (which is turned back into packets), as if it came from a sensor board.
+ * Time is virtual: readTime() gives the recorded time of the data, while the replay speed only decides how long to wait
+ * before giving the data out.  The data and its timestamps are therefore the same at any speed.
+ */
+class ReplayLink: public SerialLink
+{
+public:
+    // Speed is relative to real time, with 0 meaning as fast as possible
+    ReplayLink(const char *path, double speed);
+    ~ReplayLink();
+
+    // At the end of the recording, read() fails with NoError
+    QSerialPort::SerialPortError error() { return replayError; }
+    int64_t read(std::vector<char> &buffer);
+    int64_t write(const char * /*data*/, int64_t size) { return size; }     // commands to the device are irrelevant
+    void wakeUp();
+    int64_t readTime() { return virtualTime; }
+    int64_t now() { return virtualTime + clock.nsecsElapsed() - readWallTime; }
+
+    // The sample period the recording was made with, or 0 if it cannot be told
+    unsigned int periodMs() const { return recordedPeriodMs; }
+
+private:
+    bool readRawRecord();
+    bool readCsvRecord();
+    void detectCsvPeriod();
+    bool waitFor(int64_t time);
+
+    FILE *file;
+    bool csv;
+    double speed;
+    unsigned int recordedPeriodMs;
+    QSerialPort::SerialPortError replayError;
+
+    // The next chunk of data to give out
+    std::vector<char> pending;
+    int64_t pendingTime;
+    bool hasPending;
+
+    // The virtual clock: firstTime is the recorded time that corresponds to the start of the replay
+    int64_t firstTime;
+    int64_t virtualTime;
+    int64_t readWallTime;       // when the data at virtualTime was given out, so now() advances in real time from there
+
+    QMutex wakeMutex;
+    QWaitCondition wakeCondition;
+    bool wokenUp;
+};
+
+#endif // REPLAY_H
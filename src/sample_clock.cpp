@@ -0,0 +1,99 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sample_clock.h"
+#include <math.h>
+
+// The loop starts with a wide bandwidth to lock quickly, then narrows to smooth out jitter
+#define STARTUP_BANDWIDTH_HZ 5.0
+#define STEADY_BANDWIDTH_HZ 0.05
+#define STARTUP_SECONDS 2.0
+
+// Time constant of the jitter estimate, in samples
+#define JITTER_AVERAGING 1000.0
+
+SampleClock::SampleClock()
+{
+    reset(1000000);
+}
+
+void SampleClock::reset(int64_t nominalPeriod_)
+{
+    nominalPeriod = nominalPeriod_;
+    samples = 0;
+    next = 0;
+    period = nominalPeriod;
+    errorVariance = 0;
+    setBandwidth(STARTUP_BANDWIDTH_HZ);
+}
+
+void SampleClock::setBandwidth(double hz)
+{
+    double omega = 2 * M_PI * hz * nominalPeriod * 1e-9;
+
+    b = sqrt(2) * omega;
+    c = omega * omega;
+}
+
+int64_t SampleClock::update(int64_t arrival)
+{
+    if (samples == 0)
+    {
+        next = arrival + period;
+        ++samples;
+        return arrival;
+    }
+
+    if (samples == (uint64_t)(STARTUP_SECONDS * 1e9 / nominalPeriod))
+        setBandwidth(STEADY_BANDWIDTH_HZ);
+
+    double current = next;
+    double error = arrival - current;
+
+    // If there was a long pause (e.g. the device stopped sending), start over rather than slowly catching up
+    if (error > 1000 * period)
+    {
+        int64_t np = nominalPeriod;
+        reset(np);
+        return update(arrival);
+    }
+
+    errorVariance += (error * error - errorVariance) / JITTER_AVERAGING;
+
+    // Never let the time go backwards or stall, even if a burst of samples arrived at once
+    double step = period + b * error;
+    if (step < period / 2)
+        step = period / 2;
+
+    next = current + step;
+    period += c * error;
+    ++samples;
+
+    return (int64_t)current;
+}
+
+SampleClockStats SampleClock::stats() const
+{
+    SampleClockStats s;
+
+    s.period = period;
+    s.jitter = sqrt(errorVariance);
+    s.drift = (nominalPeriod - period) / period * 1e6;
+
+    return s;
+}
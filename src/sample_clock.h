@@ -0,0 +1,62 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SAMPLE_CLOCK_H
+#define SAMPLE_CLOCK_H
+
+#include <stdint.h>
+
+struct SampleClockStats
+{
+    double period;      // estimated true sample period (ns of host time)
+    double jitter;      // RMS deviation of arrival times from the estimated sample times (ns)
+    double drift;       // device clock relative to host clock, in ppm
+};
+
+/*
+ * Reconstructs the times at which the device took its samples from the (noisy, bursty) times at which the host
+ * received them.  This is a delay-locked loop as described in "Using a DLL to filter time" by Fons Adriaensen: the
+ * predicted time of the next sample is corrected by a fraction of the error between prediction and arrival, and the
+ * period is adjusted by a smaller fraction of it.  The result is a smooth, strictly increasing time base that follows
+ * the device clock, at a cost of a few multiplications per sample.
+ */
+class SampleClock
+{
+public:
+    SampleClock();
+
+    void reset(int64_t nominalPeriod);
+
+    // Give the arrival time of the next sample and get its reconstructed time, both in ns
+    int64_t update(int64_t arrival);
+
+    SampleClockStats stats() const;
+
+private:
+    void setBandwidth(double hz);
+
+    int64_t nominalPeriod;
+    uint64_t samples;
+
+    double next;        // predicted time of next sample
+    double period;
+    double b, c;        // loop coefficients
+    double errorVariance;
+};
+
+#endif // SAMPLE_CLOCK_H
@@ -0,0 +1,72 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "serial_link.h"
+
+SerialLink *SerialLink::open(SerialBackend backend, const char *portName)
+{
+#ifdef Q_OS_LINUX
+    if (backend == SERIAL_BACKEND_POSIX)
+        return new PosixSerialLink(portName);
+#endif
+
+    return new QtSerialLink(portName);
+}
+
+QtSerialLink::QtSerialLink(const char *portName)
+{
+    port = new QSerialPort;
+
+    port->setPortName(portName);
+    port->setBaudRate(QSerialPort::Baud115200);
+    port->setDataBits(QSerialPort::Data8);
+    port->setParity(QSerialPort::NoParity);
+    port->setStopBits(QSerialPort::OneStop);
+    port->setFlowControl(QSerialPort::NoFlowControl);
+
+    port->open(QIODevice::ReadWrite);
+}
+
+QtSerialLink::~QtSerialLink()
+{
+    delete port;
+}
+
+int64_t QtSerialLink::read(std::vector<char> &buffer)
+{
+    // Call waitForReadyRead to process messages (remember, the acquisition thread doesn't have a QT event loop)
+    port->waitForReadyRead(1);
+
+    int64_t available = port->bytesAvailable();
+    if (available <= 0)
+        return 0;
+
+    // Make sure there is enough room in the buffer
+    if (buffer.size() < (uint64_t)available)
+        buffer.resize(available);
+
+    return port->read(buffer.data(), available);
+}
+
+int64_t QtSerialLink::write(const char *data, int64_t size)
+{
+    int64_t written = port->write(data, size);
+    port->waitForBytesWritten(1);
+
+    return written;
+}
@@ -0,0 +1,106 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERIAL_LINK_H
+#define SERIAL_LINK_H
+
+#include <QSerialPort>
+#include <QElapsedTimer>
+#include <vector>
+#include <stdint.h>
+
+enum SerialBackend
+{
+    SERIAL_BACKEND_QT,          // QSerialPort, available everywhere
+    SERIAL_BACKEND_POSIX,       // termios and poll, Linux only
+};
+
+/*
+ * The byte stream to and from the sensor.  Once opened, the link is used only by the acquisition thread, except for
+ * wakeUp() which is used by other threads to interrupt a blocking read().
+ */
+class SerialLink
+{
+public:
+    SerialLink() { clock.start(); }
+    virtual ~SerialLink() {}
+
+    // Errors are reported with QSerialPort's codes regardless of the backend
+    virtual QSerialPort::SerialPortError error() = 0;
+
+    // Wait for data and read whatever is available, growing the buffer if needed.  Returns the number of bytes read,
+    // which is 0 on timeout or if woken up, or -1 on error.
+    virtual int64_t read(std::vector<char> &buffer) = 0;
+    virtual int64_t write(const char *data, int64_t size) = 0;
+    virtual void wakeUp() {}
+
+    // Time at which the last read() returned, in ns.  Real ports use the host's monotonic clock, while replayed data
+    // uses the time of the recording so that timestamps don't depend on the replay speed.
+    virtual int64_t readTime() { return clock.nsecsElapsed(); }
+
+    // The current time on the same clock as readTime()
+    virtual int64_t now() { return clock.nsecsElapsed(); }
+
+    virtual void moveToThread(QThread * /*thread*/) {}
+
+    static SerialLink *open(SerialBackend backend, const char *portName);
+
+protected:
+    QElapsedTimer clock;
+};
+
+class QtSerialLink: public SerialLink
+{
+public:
+    QtSerialLink(const char *portName);
+    ~QtSerialLink();
+
+    QSerialPort::SerialPortError error() { return port->error(); }
+    int64_t read(std::vector<char> &buffer);
+    int64_t write(const char *data, int64_t size);
+
+    void moveToThread(QThread *thread) { port->moveToThread(thread); }
+
+private:
+    QSerialPort *port;
+};
+
+#ifdef Q_OS_LINUX
+/*
+ * Reads the tty directly, blocking in poll() until data arrives instead of polling QSerialPort every millisecond.  An
+ * eventfd is polled along with the tty so that wakeUp() can interrupt the wait without a timeout.
+ */
+class PosixSerialLink: public SerialLink
+{
+public:
+    PosixSerialLink(const char *portName);
+    ~PosixSerialLink();
+
+    QSerialPort::SerialPortError error() { return portError; }
+    int64_t read(std::vector<char> &buffer);
+    int64_t write(const char *data, int64_t size);
+    void wakeUp();
+
+private:
+    int fd;
+    int wakeFd;
+    QSerialPort::SerialPortError portError;
+};
+#endif
+
+#endif // SERIAL_LINK_H
@@ -0,0 +1,199 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "serial_link.h"
+#include <string>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <linux/serial.h>
+
+static QSerialPort::SerialPortError errnoToPortError(int err)
+{
+    switch (err)
+    {
+    case EACCES:
+    case EPERM:
+        return QSerialPort::PermissionError;
+    case EBUSY:
+        return QSerialPort::OpenError;
+    case ENOENT:
+    case ENODEV:
+    case ENXIO:
+        return QSerialPort::DeviceNotFoundError;
+    default:
+        return QSerialPort::UnknownError;
+    }
+}
+
+static bool setRawMode(int fd)
+{
+    struct termios tio;
+
+    if (tcgetattr(fd, &tio) < 0)
+        return false;
+
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, B115200);
+    cfsetospeed(&tio, B115200);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+
+    // The tty is non-blocking and poll() does the waiting, so read() should return immediately with whatever is there
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+
+    if (tcsetattr(fd, TCSANOW, &tio) < 0)
+        return false;
+
+    tcflush(fd, TCIOFLUSH);
+
+    return true;
+}
+
+static void requestLowLatency(int fd)
+{
+    struct serial_struct serial;
+
+    // USB-serial adapters such as FTDI otherwise hold data for up to 16ms before passing it on.  Not all drivers
+    // support this (e.g. CDC-ACM and ptys don't, but they don't need it either), so failure is ignored.
+    if (ioctl(fd, TIOCGSERIAL, &serial) < 0)
+        return;
+
+    serial.flags |= ASYNC_LOW_LATENCY;
+    ioctl(fd, TIOCSSERIAL, &serial);
+}
+
+PosixSerialLink::PosixSerialLink(const char *portName):
+    fd(-1), wakeFd(-1), portError(QSerialPort::NoError)
+{
+    // Port names from QSerialPortInfo are just the device name
+    std::string path = portName;
+    if (path.find('/') == std::string::npos)
+        path = "/dev/" + path;
+
+    fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+    {
+        portError = errnoToPortError(errno);
+        return;
+    }
+
+    // Like QSerialPort, don't share the port with other applications
+    if (ioctl(fd, TIOCEXCL) < 0 || !setRawMode(fd))
+    {
+        portError = errnoToPortError(errno);
+        if (portError == QSerialPort::UnknownError)
+            portError = QSerialPort::OpenError;
+        return;
+    }
+
+    requestLowLatency(fd);
+
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0)
+        portError = QSerialPort::ResourceError;
+}
+
+PosixSerialLink::~PosixSerialLink()
+{
+    if (fd >= 0)
+        close(fd);
+    if (wakeFd >= 0)
+        close(wakeFd);
+}
+
+int64_t PosixSerialLink::read(std::vector<char> &buffer)
+{
+    struct pollfd fds[2];
+
+    fds[0].fd = fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = wakeFd;
+    fds[1].events = POLLIN;
+
+    if (buffer.size() < 4096)
+        buffer.resize(4096);
+
+    // Wait indefinitely; wakeUp() makes sure this returns when the acquisition needs to stop
+    if (poll(fds, 2, -1) < 0)
+        return errno == EINTR?0:-1;
+
+    if (fds[1].revents & POLLIN)
+    {
+        uint64_t count;
+        if (::read(wakeFd, &count, sizeof count) < 0)
+        {
+            // Nothing to do, the eventfd is only used to break the poll
+        }
+        return 0;
+    }
+
+    if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL))
+    {
+        portError = QSerialPort::ResourceError;
+        return -1;
+    }
+
+    ssize_t r = ::read(fd, buffer.data(), buffer.size());
+    if (r < 0)
+        return errno == EAGAIN || errno == EINTR?0:-1;
+
+    return r;
+}
+
+int64_t PosixSerialLink::write(const char *data, int64_t size)
+{
+    int64_t written = 0;
+
+    while (written < size)
+    {
+        ssize_t w = ::write(fd, data + written, size - written);
+        if (w < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN)
+                return -1;
+
+            // The output buffer is full, wait for it to drain
+            struct pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLOUT;
+            poll(&pfd, 1, 10);
+            continue;
+        }
+
+        written += w;
+    }
+
+    return written;
+}
+
+void PosixSerialLink::wakeUp()
+{
+    uint64_t one = 1;
+    if (::write(wakeFd, &one, sizeof one) < 0)
+    {
+        // If the eventfd counter is saturated, a wake up is already pending
+    }
+}
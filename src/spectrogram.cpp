@@ -0,0 +1,141 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spectrogram.h"
+#include "heatmap.h"
+#include <math.h>
+
+#define SPECTROGRAM_RANGE_DB 80
+#define SPECTROGRAM_STEP_DB 10
+
+Spectrogram::Spectrogram():
+    binCount(0),
+    first(0),
+    count(0),
+    top(0),
+    range(SPECTROGRAM_RANGE_DB)
+{
+}
+
+void Spectrogram::configure(unsigned int bins, size_t columns)
+{
+    binCount = bins;
+    spectra.resize((size_t)bins * columns);
+    times.resize(columns);
+    clear();
+}
+
+void Spectrogram::clear()
+{
+    first = 0;
+    count = 0;
+    top = 0;
+}
+
+float Spectrogram::loudest(const float *spectrum) const
+{
+    float m = spectrum[0];
+    for (unsigned int k = 1; k < binCount; ++k)
+        if (spectrum[k] > m)
+            m = spectrum[k];
+    return m;
+}
+
+bool Spectrogram::add(double time, const double *density)
+{
+    if (times.empty() || binCount == 0)
+        return false;
+
+    // Overwrite the oldest spectrum once full
+    size_t slot;
+    if (count < times.size())
+        slot = index(count++);
+    else
+    {
+        slot = first;
+        first = (first + 1) % times.size();
+    }
+
+    float *s = &spectra[slot * binCount];
+    for (unsigned int k = 0; k < binCount; ++k)
+        s[k] = 10 * log10(density[k] > 1e-30?density[k]:1e-30);
+    times[slot] = time;
+
+    // Grow the scale in steps, so it doesn't change with every spectrum
+    float m = loudest(s);
+    if (count == 1 || m > top)
+    {
+        top = ceil(m / SPECTROGRAM_STEP_DB) * SPECTROGRAM_STEP_DB;
+        return true;
+    }
+    return false;
+}
+
+bool Spectrogram::refit()
+{
+    if (count == 0)
+        return false;
+
+    float m = loudest(spectrum(0));
+    for (size_t i = 1; i < count; ++i)
+    {
+        float l = loudest(spectrum(i));
+        if (l > m)
+            m = l;
+    }
+
+    double fitted = ceil(m / SPECTROGRAM_STEP_DB) * SPECTROGRAM_STEP_DB;
+    if (fitted == top)
+        return false;
+    top = fitted;
+    return true;
+}
+
+void Spectrogram::color(const float *spectrum, int rows, uint32_t *pixels)
+{
+    if (rows <= 0 || binCount == 0)
+        return;
+
+    // Row r (from the bottom) covers the bins from r to r + 1 rows' worth of the spectrum
+    rowValues.resize(rows);
+    double binsPerRow = (double)(binCount - 1) / rows;
+    for (int r = 0; r < rows; ++r)
+    {
+        double from = r * binsPerRow;
+        double to = from + binsPerRow;
+        unsigned int k0 = (unsigned int)ceil(from);
+        unsigned int k1 = (unsigned int)floor(to);
+        if (k1 > binCount - 1)
+            k1 = binCount - 1;
+
+        float v;
+        if (k0 > k1)
+            // More rows than bins: take the nearest bin
+            v = spectrum[(unsigned int)((from + to) / 2 + 0.5)];
+        else
+        {
+            v = spectrum[k0];
+            for (unsigned int k = k0 + 1; k <= k1; ++k)
+                if (spectrum[k] > v)
+                    v = spectrum[k];
+        }
+        rowValues[rows - 1 - r] = v;
+    }
+
+    Heatmap::colorize(&rowValues[0], rows, low(), high(), pixels);
+}
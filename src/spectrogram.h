@@ -0,0 +1,76 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPECTROGRAM_H
+#define SPECTROGRAM_H
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The rolling history of a short-time Fourier transform: the last few spectra (in dB) of a stream with their times,
+ * and the color scale they are drawn with.  Every spectrum is computed once, when its segment completes, and is then
+ * only colored again if the color scale or the size of the image changes.
+ *
+ * The color scale covers a fixed range of dB below a top, which follows the loudest spectrum kept.
+ */
+class Spectrogram
+{
+public:
+    Spectrogram();
+
+    // Keep up to columns spectra of bins values each.  Clears the history.
+    void configure(unsigned int bins, size_t columns);
+    void clear();
+
+    // Add the spectrum (a density, not in dB) that ends at time.  Returns true if the color scale had to grow, in
+    // which case the spectra kept so far need to be colored again.
+    bool add(double time, const double *density);
+
+    // Lower the color scale if the loudest spectra have left.  Returns true if the scale changed.
+    bool refit();
+
+    // The kept spectra, 0 being the oldest
+    size_t size() const { return count; }
+    double time(size_t i) const { return times[index(i)]; }
+    const float *spectrum(size_t i) const { return &spectra[index(i) * binCount]; }
+
+    // Color a spectrum into a column of rows pixels, with the highest frequency at the top.  If there are more bins
+    // than rows, each pixel shows the loudest of its bins so that narrow peaks don't disappear.
+    void color(const float *spectrum, int rows, uint32_t *pixels);
+
+    unsigned int bins() const { return binCount; }
+    size_t capacity() const { return times.size(); }
+    double low() const { return top - range; }
+    double high() const { return top; }
+
+private:
+    size_t index(size_t i) const { return (first + i) % times.size(); }
+    float loudest(const float *spectrum) const;
+
+    unsigned int binCount;
+    std::vector<float> spectra;             // a ring of binCount values per spectrum
+    std::vector<double> times;
+    size_t first, count;
+
+    double top, range;
+    std::vector<float> rowValues;           // the spectrum resampled to the rows being colored
+};
+
+#endif // SPECTROGRAM_H
@@ -0,0 +1,177 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spectrum.h"
+#include <string.h>
+#include <math.h>
+#include <string>
+
+static std::string wisdomPath;
+
+void Welch::useWisdom(const char *path)
+{
+    wisdomPath = path;
+    fftw_import_wisdom_from_filename(path);
+}
+
+Welch::Welch():
+    segmentSize(0),
+    hop(0),
+    averaged(0),
+    windowType(SPECTRUM_HANN),
+    sampleRate(1),
+    scale(1),
+    in(NULL),
+    out(NULL),
+    buffered(0),
+    nextPeriodogram(0),
+    averagedCount(0)
+{
+}
+
+Welch::~Welch()
+{
+    if (in != NULL)
+    {
+        fftw_destroy_plan(plan);
+        fftw_free(in);
+        fftw_free(out);
+    }
+}
+
+bool Welch::configure(unsigned int segmentSize_, unsigned int hop_, unsigned int averaged_, SpectrumWindow window_,
+                      double sampleRate_)
+{
+    if (hop_ == 0 || hop_ > segmentSize_)
+        hop_ = segmentSize_;
+    if (averaged_ == 0)
+        averaged_ = 1;
+
+    if (segmentSize_ == segmentSize && hop_ == hop && averaged_ == averaged && window_ == windowType &&
+            sampleRate_ == sampleRate)
+        return false;
+
+    // Measuring overwrites the arrays, which is fine since nothing is in them yet
+    if (segmentSize_ != segmentSize)
+    {
+        if (in != NULL)
+        {
+            fftw_destroy_plan(plan);
+            fftw_free(in);
+            fftw_free(out);
+        }
+        in = fftw_alloc_real(segmentSize_);
+        out = fftw_alloc_complex(segmentSize_ / 2 + 1);
+        plan = fftw_plan_dft_r2c_1d(segmentSize_, in, out, FFTW_MEASURE);
+        if (!wisdomPath.empty())
+            fftw_export_wisdom_to_filename(wisdomPath.c_str());
+    }
+
+    segmentSize = segmentSize_;
+    hop = hop_;
+    averaged = averaged_;
+    windowType = window_;
+    sampleRate = sampleRate_;
+
+    // Periodic windows, so that overlapping segments add up evenly
+    window.resize(segmentSize);
+    double windowPower = 0;
+    for (unsigned int i = 0; i < segmentSize; ++i)
+    {
+        double phase = 2 * M_PI * i / segmentSize;
+        if (windowType == SPECTRUM_BLACKMAN)
+            window[i] = 0.42 - 0.5 * cos(phase) + 0.08 * cos(2 * phase);
+        else
+            window[i] = 0.5 - 0.5 * cos(phase);
+        windowPower += window[i] * window[i];
+    }
+    scale = 1 / (sampleRate * windowPower);
+
+    buffer.resize(segmentSize);
+    periodograms.resize((size_t)averaged * bins());
+    sum.resize(bins());
+    clear();
+
+    return true;
+}
+
+void Welch::clear()
+{
+    buffered = 0;
+    nextPeriodogram = 0;
+    averagedCount = 0;
+    if (!sum.empty())
+        memset(&sum[0], 0, sum.size() * sizeof sum[0]);
+}
+
+void Welch::addSegment()
+{
+    double mean = 0;
+    for (unsigned int i = 0; i < segmentSize; ++i)
+        mean += buffer[i];
+    mean /= segmentSize;
+
+    for (unsigned int i = 0; i < segmentSize; ++i)
+        in[i] = (buffer[i] - mean) * window[i];
+    fftw_execute(plan);
+
+    // Replace the oldest periodogram in the sum with the new one.  Once per round of the ring, the sum is recomputed
+    // from scratch so that rounding errors don't build up.
+    unsigned int n = bins();
+    double *p = &periodograms[(size_t)nextPeriodogram * n];
+    bool full = averagedCount == averaged;
+    for (unsigned int k = 0; k < n; ++k)
+    {
+        // Everything but DC and Nyquist is counted twice, for the negative frequencies
+        double power = (out[k][0] * out[k][0] + out[k][1] * out[k][1]) * scale;
+        if (k != 0 && k != segmentSize / 2)
+            power *= 2;
+        if (full)
+            sum[k] -= p[k];
+        sum[k] += power;
+        p[k] = power;
+    }
+
+    if (averagedCount < averaged)
+        ++averagedCount;
+    if (++nextPeriodogram == averaged)
+    {
+        nextPeriodogram = 0;
+        for (unsigned int k = 0; k < n; ++k)
+        {
+            double s = 0;
+            for (unsigned int j = 0; j < averaged; ++j)
+                s += periodograms[(size_t)j * n + k];
+            sum[k] = s;
+        }
+    }
+
+    // Keep the overlap for the next segment
+    memmove(&buffer[0], &buffer[hop], (segmentSize - hop) * sizeof buffer[0]);
+    buffered = segmentSize - hop;
+}
+
+void Welch::density(double *dB) const
+{
+    unsigned int n = bins();
+    for (unsigned int k = 0; k < n; ++k)
+    {
+        double d = averagedCount > 0?sum[k] / averagedCount:0;
+        dB[k] = 10 * log10(d > 1e-30?d:1e-30);
+    }
+}
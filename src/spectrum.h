@@ -0,0 +1,113 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <vector>
+#include <stddef.h>
+#include <fftw3.h>
+
+enum SpectrumWindow
+{
+    SPECTRUM_HANN,
+    SPECTRUM_BLACKMAN,
+};
+
+/*
+ * Welch's estimate of the power spectral density of a stream of samples.  The stream is cut in segments of a fixed
+ * size that overlap, each segment is detrended (mean removed), windowed and transformed once, and the estimate is the
+ * average of the periodograms of the last few segments.  New samples only cost the transform of the segments they
+ * complete, one every hop.
+ *
+ * The FFTW plan is made with FFTW_MEASURE, and is kept as long as the segment size doesn't change.  With a wisdom
+ * file, the measurements are remembered across runs so that only the first run ever pays for them.
+ */
+class Welch
+{
+public:
+    Welch();
+    ~Welch();
+
+    // Load FFTW wisdom from a file, and save it there whenever a new plan is made.  Must be called before any plan is
+    // made, since FFTW's planner is used from a single thread.
+    static void useWisdom(const char *path);
+
+    // Set the estimator up.  Returns true (and clears the estimate) if anything changed.
+    bool configure(unsigned int segmentSize, unsigned int hop, unsigned int averaged, SpectrumWindow window,
+                   double sampleRate);
+
+    // Forget the samples and the estimate, for example if the stream had a gap
+    void clear();
+
+    // Add samples to the stream.  Returns the number of segments that were completed.
+    template<typename T>
+    unsigned int push(const T *samples, size_t count)
+    {
+        unsigned int completed = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            buffer[buffered++] = samples[i];
+            if (buffered == segmentSize)
+            {
+                addSegment();
+                ++completed;
+            }
+        }
+        return completed;
+    }
+
+    // The estimate, one-sided, in dB (10 log10 of the density in unit^2/Hz) for each of the bins() frequencies
+    void density(double *dB) const;
+
+    unsigned int bins() const { return segmentSize / 2 + 1; }
+    double binWidth() const { return sampleRate / segmentSize; }
+    unsigned int hopSize() const { return hop; }
+    unsigned int segments() const { return averagedCount; }
+
+    // The periodogram (density, not in dB) of one of the last segments() segments, 0 being the newest, and how many
+    // samples before the end of the stream that segment ended.  Together they make a short-time Fourier transform.
+    const double *periodogram(unsigned int age) const
+    {
+        return &periodograms[(size_t)((nextPeriodogram + averaged - 1 - age) % averaged) * bins()];
+    }
+    size_t segmentEnd(unsigned int age) const { return buffered - (segmentSize - hop) + (size_t)age * hop; }
+
+private:
+    void addSegment();
+
+    unsigned int segmentSize, hop, averaged;
+    SpectrumWindow windowType;
+    double sampleRate;
+
+    std::vector<double> window;
+    double scale;                           // turns |X|^2 into a one-sided density
+
+    double *in;
+    fftw_complex *out;
+    fftw_plan plan;
+
+    std::vector<double> buffer;             // the segment being gathered
+    size_t buffered;
+
+    std::vector<double> periodograms;       // the last averaged periodograms, a ring of bins() values each
+    std::vector<double> sum;                // their sum
+    unsigned int nextPeriodogram, averagedCount;
+};
+
+#endif // SPECTRUM_H
@@ -0,0 +1,117 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "static_baseline.h"
+#include <math.h>
+
+#define RISE_S 300.0
+#define FALL_S 0.5
+#define SHORT_TERM_S 0.02
+#define NOISE_S 5.0
+#define OFFSET_S 5.0
+
+// A taxel is pressed when it is this many times its noise floor above its baseline, plus a margin in ADC counts
+#define CONTACT_RATIO 6
+#define CONTACT_MARGIN 50
+#define MIN_NOISE 1
+
+// Coefficient of a first order smoother with time constant tau
+static double smoothing(double tau, double sampleRate)
+{
+    return 1 - exp(-1 / (tau * sampleRate));
+}
+
+StaticBaseline::StaticBaseline()
+{
+    configure(1000);
+}
+
+void StaticBaseline::configure(double sampleRate)
+{
+    rise = smoothing(RISE_S, sampleRate);
+    fall = smoothing(FALL_S, sampleRate);
+    noiseRate = smoothing(NOISE_S, sampleRate);
+    shortRate = smoothing(SHORT_TERM_S, sampleRate);
+    offsetTime = (unsigned int)(OFFSET_S * sampleRate);
+    offsetSamples = 0;
+    meanNoise = MIN_NOISE;
+    fresh = true;
+    contact = false;
+}
+
+void StaticBaseline::update(const uint16_t *taxels, bool externalContact, uint16_t *compensated)
+{
+    if (fresh)
+    {
+        for (int t = 0; t < FINGER_STATIC_TACTILE_COUNT; ++t)
+        {
+            baseline[t] = shortTerm[t] = taxels[t];
+            noiseFloor[t] = MIN_NOISE;
+        }
+        meanNoise = MIN_NOISE;
+        offsetSamples = 0;
+        fresh = false;
+    }
+
+    // First look at the sample as it is, to know whether to learn from it
+    contact = externalContact;
+    for (int t = 0; t < FINGER_STATIC_TACTILE_COUNT; ++t)
+    {
+        float above = taxels[t] - baseline[t];
+        if (above > CONTACT_RATIO * noiseFloor[t] + CONTACT_MARGIN)
+            contact = true;
+        compensated[t] = above > 0?(uint16_t)(above + 0.5f):0;
+    }
+    for (int t = 0; t < FINGER_STATIC_TACTILE_COUNT; ++t)
+        shortTerm[t] += (taxels[t] - shortTerm[t]) * shortRate;
+
+    if (contact)
+    {
+        // An object presses some taxels more than others.  If instead they have all moved alike, it's an offset.
+        double lowest = shortTerm[0] - baseline[0], highest = lowest;
+        for (int t = 1; t < FINGER_STATIC_TACTILE_COUNT; ++t)
+        {
+            double shift = shortTerm[t] - baseline[t];
+            if (shift < lowest) lowest = shift;
+            if (shift > highest) highest = shift;
+        }
+
+        bool offset = !externalContact && highest - lowest <= CONTACT_RATIO * meanNoise + CONTACT_MARGIN;
+        offsetSamples = offset?offsetSamples + 1:0;
+        if (offsetSamples < offsetTime)
+            return;
+
+        for (int t = 0; t < FINGER_STATIC_TACTILE_COUNT; ++t)
+            baseline[t] = shortTerm[t];
+        offsetSamples = 0;
+        return;
+    }
+    offsetSamples = 0;
+
+    double noiseSum = 0;
+    for (int t = 0; t < FINGER_STATIC_TACTILE_COUNT; ++t)
+    {
+        double deviation = taxels[t] - baseline[t];
+        baseline[t] += deviation * (deviation < 0?fall:rise);
+        noiseFloor[t] += (fabsf(taxels[t] - shortTerm[t]) - noiseFloor[t]) * noiseRate;
+        if (noiseFloor[t] < MIN_NOISE)
+            noiseFloor[t] = MIN_NOISE;
+        noiseSum += noiseFloor[t];
+    }
+    meanNoise = noiseSum / FINGER_STATIC_TACTILE_COUNT;
+}
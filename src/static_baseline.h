@@ -0,0 +1,69 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STATIC_BASELINE_H
+#define STATIC_BASELINE_H
+
+#include <stdint.h>
+#include "finger_data.h"
+
+/*
+ * Continuous drift compensation of the static taxels of one finger.  Every taxel has a baseline, a slow exponential
+ * average of its readings (minutes, like thermal drift), and a noise floor, the average distance of the readings from
+ * their short term average.  Pressure only raises the readings, so the baseline follows quickly when a reading goes
+ * below it, and slowly when above.
+ *
+ * While the finger is in contact, which is when any taxel stands out of its noise (or when told so by the caller,
+ * e.g. from the dynamic sensor), nothing is learned, so that a held object is not taken for drift however long it is
+ * held.  The only exception is when every taxel has shifted by about the same amount for a few seconds, which is an
+ * offset (e.g. drift that built up during a long contact) rather than an object; the baseline then jumps to it.
+ *
+ * The cost is O(taxels) per sample.
+ */
+class StaticBaseline
+{
+public:
+    StaticBaseline();
+
+    // Set up for a sample rate.  Also resets.
+    void configure(double sampleRate);
+
+    // Take the next sample as the baseline
+    void reset() { fresh = true; }
+
+    // Add a sample and get the taxels above their baseline (0 if below).  The rest of the state is updated as well.
+    void update(const uint16_t *taxels, bool contact, uint16_t *compensated);
+
+    // Average noise floor of the taxels, and whether the last sample was considered a contact
+    double noise() const { return meanNoise; }
+    bool inContact() const { return contact; }
+
+private:
+    double rise, fall, noiseRate, shortRate;
+    unsigned int offsetTime;
+
+    double baseline[FINGER_STATIC_TACTILE_COUNT];     // double, since the slow average moves by tiny steps
+    float shortTerm[FINGER_STATIC_TACTILE_COUNT];
+    float noiseFloor[FINGER_STATIC_TACTILE_COUNT];
+    double meanNoise;
+    bool fresh;
+    bool contact;
+    unsigned int offsetSamples;             // how long all taxels have been shifted alike
+};
+
+#endif // STATIC_BASELINE_H
@@ -0,0 +1,253 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "strip_chart.h"
+#include <string.h>
+#include <math.h>
+
+static uint32_t packColor(uint8_t r, uint8_t g, uint8_t b)
+{
+    // Stored as the bytes R, G, B, A, whatever the endianness
+    uint8_t rgba[4] = {r, g, b, 255};
+    uint32_t color;
+    memcpy(&color, rgba, 4);
+    return color;
+}
+
+static const uint32_t white = packColor(255, 255, 255);
+
+StripChart::StripChart():
+    imageWidth(0),
+    imageHeight(0),
+    plotLeft(0),
+    plotTop(0),
+    plotWidth(0),
+    plotHeight(0),
+    columnTime(1),
+    valueLow(0),
+    valueHigh(1),
+    empty(true),
+    newestColumn(0),
+    filledColumn(0)
+{
+}
+
+void StripChart::configure(const unsigned char *overlay, int width, int height, int left, int top, int right, int bottom,
+                           double window, double low, double high, int traces)
+{
+    // Keep the plot inside the image
+    if (left < 0) left = 0;
+    if (top < 0) top = 0;
+    if (right > width) right = width;
+    if (bottom > height) bottom = height;
+
+    imageWidth = width;
+    imageHeight = height;
+    plotLeft = left;
+    plotTop = top;
+    plotWidth = right > left?right - left:0;
+    plotHeight = bottom > top?bottom - top:0;
+    columnTime = plotWidth > 0 && window > 0?window / plotWidth:1;
+    valueLow = low;
+    valueHigh = high > low?high:low + 1;
+
+    image.resize((size_t)width * height);
+    memcpy(&image[0], overlay, image.size() * 4);
+    strip.resize((size_t)plotWidth * plotHeight);
+
+    // Only the overlay pixels inside the plot need to be redrawn every frame
+    overlayPlot.clear();
+    for (int y = plotTop; y < plotTop + plotHeight; ++y)
+        for (int x = plotLeft; x < plotLeft + plotWidth; ++x)
+        {
+            size_t index = (size_t)y * width + x;
+            if (image[index] != white)
+            {
+                OverlayPixel p = {index, image[index]};
+                overlayPlot.push_back(p);
+            }
+        }
+
+    colors.resize(traces, packColor(0, 0, 255));
+    lastColumn.resize(traces);
+    lastRow.resize(traces);
+
+    clear();
+}
+
+void StripChart::setColor(int trace, uint8_t r, uint8_t g, uint8_t b)
+{
+    colors[trace] = packColor(r, g, b);
+}
+
+void StripChart::clear()
+{
+    for (size_t i = 0; i < strip.size(); ++i)
+        strip[i] = white;
+    empty = true;
+}
+
+double StripChart::row(double value) const
+{
+    double r = (valueHigh - value) / (valueHigh - valueLow) * (plotHeight - 1);
+    if (r < 0)
+        r = 0;
+    if (r > plotHeight - 1)
+        r = plotHeight - 1;
+    return r;
+}
+
+size_t StripChart::slot(int64_t column) const
+{
+    int64_t s = column % plotWidth;
+    return s < 0?s + plotWidth:s;
+}
+
+void StripChart::advance(int64_t column)
+{
+    int64_t shift = column - newestColumn;
+
+    // Clear the columns that scroll in, which are the oldest ones in the ring
+    if (shift >= plotWidth)
+        for (size_t i = 0; i < strip.size(); ++i)
+            strip[i] = white;
+    else
+        for (int64_t c = newestColumn + 1; c <= column; ++c)
+        {
+            uint32_t *p = &strip[slot(c)];
+            for (int y = 0; y < plotHeight; ++y)
+                p[(size_t)y * plotWidth] = white;
+        }
+
+    newestColumn = column;
+}
+
+void StripChart::drawSpan(int64_t column, double fromRow, double toRow, uint32_t color)
+{
+    int from = (int)(fromRow + 0.5);
+    int to = (int)(toRow + 0.5);
+    if (from > to)
+    {
+        int t = from;
+        from = to;
+        to = t;
+    }
+
+    uint32_t *p = &strip[slot(column)];
+    for (int y = from; y <= to; ++y)
+        p[(size_t)y * plotWidth] = color;
+}
+
+void StripChart::append(double time, const double *values)
+{
+    if (plotWidth == 0 || plotHeight == 0)
+        return;
+
+    int64_t column = (int64_t)floor(time / columnTime);
+    if (empty)
+    {
+        newestColumn = column;
+        for (size_t t = 0; t < colors.size(); ++t)
+            lastColumn[t] = column - plotWidth;
+        empty = false;
+    }
+    else if (column > newestColumn)
+        advance(column);
+
+    // Samples older than the window (the clock went back) are not shown
+    int64_t oldestColumn = newestColumn - plotWidth + 1;
+    if (column < oldestColumn)
+        return;
+
+    for (size_t t = 0; t < colors.size(); ++t)
+    {
+        double r = row(values[t]);
+
+        // Connect to the previous sample with a line, as one vertical span per column it crosses
+        if (lastColumn[t] < column && lastColumn[t] >= oldestColumn - 1)
+        {
+            double step = (r - lastRow[t]) / (column - lastColumn[t]);
+            double from = lastRow[t];
+            for (int64_t c = lastColumn[t] + 1; c <= column; ++c)
+            {
+                double to = from + step;
+                if (c >= oldestColumn)
+                    drawSpan(c, from, to, colors[t]);
+                from = to;
+            }
+        }
+        else if (lastColumn[t] == column)
+            drawSpan(column, lastRow[t], r, colors[t]);
+        else
+            drawSpan(column, r, r, colors[t]);
+
+        lastColumn[t] = column;
+        lastRow[t] = r;
+    }
+}
+
+void StripChart::appendColumn(double time, const uint32_t *pixels)
+{
+    if (plotWidth == 0 || plotHeight == 0)
+        return;
+
+    int64_t column = (int64_t)floor(time / columnTime);
+    if (empty)
+    {
+        newestColumn = column;
+        filledColumn = column - 1;
+        empty = false;
+    }
+    else if (column > newestColumn)
+        advance(column);
+
+    int64_t oldestColumn = newestColumn - plotWidth + 1;
+    if (column < oldestColumn)
+        return;
+
+    // Each column holds until the next one, so columns further apart than a pixel leave no gaps
+    int64_t from = filledColumn < column && filledColumn >= oldestColumn - 1?filledColumn + 1:column;
+    for (int64_t c = from; c <= column; ++c)
+    {
+        uint32_t *p = &strip[slot(c)];
+        for (int y = 0; y < plotHeight; ++y)
+            p[(size_t)y * plotWidth] = pixels[y];
+    }
+    filledColumn = column;
+}
+
+const unsigned char *StripChart::compose()
+{
+    if (image.empty())
+        return NULL;
+
+    // The oldest column goes to the left edge of the plot
+    int start = empty || plotWidth == 0?0:(int)slot(newestColumn + 1);
+    for (int y = 0; y < plotHeight; ++y)
+    {
+        uint32_t *out = &image[(size_t)(plotTop + y) * imageWidth + plotLeft];
+        const uint32_t *in = &strip[(size_t)y * plotWidth];
+        memcpy(out, in + start, (size_t)(plotWidth - start) * 4);
+        memcpy(out + plotWidth - start, in, (size_t)start * 4);
+    }
+
+    for (size_t i = 0; i < overlayPlot.size(); ++i)
+        image[overlayPlot[i].index] = overlayPlot[i].color;
+
+    return (const unsigned char *)&image[0];
+}
@@ -0,0 +1,97 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STRIP_CHART_H
+#define STRIP_CHART_H
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A scrolling waveform, drawn incrementally.  The plot area is a ring of pixel columns, each covering a fixed slice of
+ * time.  New samples only clear the columns the chart scrolls by and draw the line segments up to them, so the cost of
+ * a frame is proportional to the new data, not to the length of the window.  The rest of the graph (axes, labels,
+ * legend) is an overlay that is rendered once by the caller, and is drawn over the strip wherever it isn't white.
+ *
+ * The right edge of the strip is the newest sample, so the time axis of the overlay should run from -window to 0.
+ *
+ * Instead of traces, the strip can also be given whole columns of pixels, such as the spectra of a spectrogram.
+ */
+class StripChart
+{
+public:
+    StripChart();
+
+    // Lay out the chart: the overlay is a width x height RGBA image, in which the plot covers [left, right) x
+    // [top, bottom) and shows the last window seconds of values between low and high.  This clears the strip.
+    void configure(const unsigned char *overlay, int width, int height, int left, int top, int right, int bottom,
+                   double window, double low, double high, int traces);
+    void setColor(int trace, uint8_t r, uint8_t g, uint8_t b);
+
+    // Start over with an empty strip
+    void clear();
+
+    // Add one sample of every trace
+    void append(double time, const double *values);
+
+    // Fill the strip from the previous column given this way up to the column at time, with rows() pixels from top to
+    // bottom
+    void appendColumn(double time, const uint32_t *pixels);
+    int rows() const { return plotHeight; }
+
+    // Draw the strip under the overlay, and get the final image (RGBA8888)
+    const unsigned char *compose();
+
+    int width() const { return imageWidth; }
+    int height() const { return imageHeight; }
+    double low() const { return valueLow; }
+    double high() const { return valueHigh; }
+
+private:
+    void advance(int64_t column);
+    void drawSpan(int64_t column, double fromRow, double toRow, uint32_t color);
+    double row(double value) const;
+    size_t slot(int64_t column) const;
+
+    struct OverlayPixel
+    {
+        size_t index;
+        uint32_t color;
+    };
+
+    int imageWidth, imageHeight;
+    int plotLeft, plotTop, plotWidth, plotHeight;
+    double columnTime;
+    double valueLow, valueHigh;
+
+    std::vector<uint32_t> image;            // overlay with the strip drawn in
+    std::vector<uint32_t> strip;            // plotHeight rows of plotWidth columns, column c at index c % plotWidth
+    std::vector<OverlayPixel> overlayPlot;  // the parts of the overlay that are inside the plot
+
+    bool empty;
+    int64_t newestColumn;                   // the column of the right edge, counted from time 0
+    int64_t filledColumn;                   // the last column given by appendColumn()
+
+    // Per trace, the color and where the last sample was drawn
+    std::vector<uint32_t> colors;
+    std::vector<int64_t> lastColumn;
+    std::vector<double> lastRow;
+};
+
+#endif // STRIP_CHART_H
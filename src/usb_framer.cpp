@@ -0,0 +1,215 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "usb_framer.h"
+#include <string.h>
+
+static inline bool packetLengthValid(const uint8_t *p)
+{
+    return p[3] <= USB_PACKET_MAX_DATA_LENGTH;
+}
+
+static inline size_t packetSize(const uint8_t *p)
+{
+    return p[3] + USB_PACKET_HEADER_SIZE;
+}
+
+static inline bool packetCrcValid(const uint8_t *p)
+{
+    return p[1] == calcCrc8(p + 2, p[3] + 2);
+}
+
+UsbFramer::UsbFramer()
+{
+    reset();
+}
+
+void UsbFramer::reset()
+{
+    chunk = NULL;
+    chunkSize = 0;
+    chunkPos = 0;
+    partialStart = 0;
+    partialSize = 0;
+
+    linkStats.goodFrames = 0;
+    linkStats.crcFailures = 0;
+    linkStats.resyncs = 0;
+    linkStats.discardedBytes = 0;
+    synced = false;
+}
+
+void UsbFramer::discard(size_t count)
+{
+    // Discarding right after a good packet means sync was lost.  Everything discarded until the next good packet is
+    // part of the same resync, however it is cut into chunks.
+    if (count == 0)
+        return;
+
+    if (synced)
+        ++linkStats.resyncs;
+    synced = false;
+    linkStats.discardedBytes += count;
+}
+
+void UsbFramer::feed(const uint8_t *data, size_t size)
+{
+    chunk = data;
+    chunkSize = size;
+    chunkPos = 0;
+}
+
+const UsbPacket *UsbFramer::next()
+{
+    // If a packet was split in the previous chunk, complete it first
+    if (partialSize > 0)
+    {
+        const UsbPacket *packet = nextPartial();
+        if (packet != NULL || partialSize > 0)
+            return packet;
+    }
+
+    return nextInChunk();
+}
+
+bool UsbFramer::takeIntoPartial(size_t upTo)
+{
+    // After a resync, the buffer may already hold more than asked for
+    if (partialSize >= upTo)
+        return true;
+
+    size_t take = upTo - partialSize;
+    if (take > chunkSize - chunkPos)
+        take = chunkSize - chunkPos;
+
+    memcpy(partial + partialSize, chunk + chunkPos, take);
+    partialSize += take;
+    chunkPos += take;
+
+    return partialSize == upTo;
+}
+
+void UsbFramer::skipPartial(size_t count)
+{
+    // Drop the first count bytes of the buffer, and the bytes after them up to the next start byte, if any.  Bytes that
+    // are not yet taken from the chunk will be looked at by nextInChunk() if there is none.
+    const uint8_t *start = (const uint8_t *)memchr(partial + count, USB_PACKET_START_BYTE, partialSize - count);
+    size_t shift = start == NULL?partialSize:start - partial;
+
+    discard(shift - count);
+
+    memmove(partial, partial + shift, partialSize - shift);
+    partialSize -= shift;
+}
+
+void UsbFramer::resyncPartial()
+{
+    // Drop the current start byte, like nextInChunk() does
+    discard(1);
+    skipPartial(1);
+}
+
+const UsbPacket *UsbFramer::nextPartial()
+{
+    // Drop the packet that was returned last time.  After a resync, there may be more bytes buffered after it, which
+    // are looked at from the next start byte on, as if the packet had been in the chunk.
+    if (partialStart > 0)
+    {
+        skipPartial(partialStart);
+        partialStart = 0;
+    }
+
+    while (partialSize > 0)
+    {
+        // Get the header first, so the length of the packet is known
+        if (partialSize < USB_PACKET_HEADER_SIZE && !takeIntoPartial(USB_PACKET_HEADER_SIZE))
+            return NULL;
+
+        if (!packetLengthValid(partial))
+        {
+            resyncPartial();
+            continue;
+        }
+
+        size_t size = packetSize(partial);
+        if (partialSize < size && !takeIntoPartial(size))
+            return NULL;
+
+        if (packetCrcValid(partial))
+        {
+            partialStart = size;
+            ++linkStats.goodFrames;
+            synced = true;
+            return (const UsbPacket *)partial;
+        }
+
+        ++linkStats.crcFailures;
+        resyncPartial();
+    }
+
+    return NULL;
+}
+
+const UsbPacket *UsbFramer::nextInChunk()
+{
+    while (chunkPos < chunkSize)
+    {
+        // Skip to the next start byte.  memchr is vectorized by the C library, so garbage is skipped quickly.
+        const uint8_t *p = (const uint8_t *)memchr(chunk + chunkPos, USB_PACKET_START_BYTE, chunkSize - chunkPos);
+        if (p == NULL)
+        {
+            discard(chunkSize - chunkPos);
+            chunkPos = chunkSize;
+            break;
+        }
+
+        discard(p - (chunk + chunkPos));
+        chunkPos = p - chunk;
+        size_t remaining = chunkSize - chunkPos;
+
+        // If the packet is not complete, keep it for the next chunk
+        if (remaining < USB_PACKET_HEADER_SIZE || (packetLengthValid(p) && remaining < packetSize(p)))
+        {
+            memcpy(partial, p, remaining);
+            partialStart = 0;
+            partialSize = remaining;
+            chunkPos = chunkSize;
+            break;
+        }
+
+        // If the packet is ok, return it in place.  Otherwise, look for the next start byte.
+        if (packetLengthValid(p))
+        {
+            if (packetCrcValid(p))
+            {
+                chunkPos += packetSize(p);
+                ++linkStats.goodFrames;
+                synced = true;
+            synced = true;
+                return (const UsbPacket *)p;
+            }
+
+            ++linkStats.crcFailures;
+        }
+
+        discard(1);
+        ++chunkPos;
+    }
+
+    return NULL;
+}
@@ -0,0 +1,77 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USB_FRAMER_H
+#define USB_FRAMER_H
+
+#include "usb_protocol.h"
+
+// Running counters on the quality of the link
+struct UsbLinkStats
+{
+    uint64_t goodFrames;        // packets with correct CRC
+    uint64_t crcFailures;       // packets with a valid length, but wrong CRC
+    uint64_t resyncs;           // number of times sync was lost after a good packet, due to corruption or garbage
+    uint64_t discardedBytes;    // bytes that were not part of any good packet
+};
+
+/*
+ * Splits a stream of received bytes into UsbPackets.  A whole chunk of received data is given to feed(), and next() is
+ * then called repeatedly to get the packets in that chunk.  Packets that lie entirely in the chunk are returned as
+ * pointers into it, so nothing is copied.  A packet that is cut between two chunks is kept aside and completed by the
+ * following feed().
+ *
+ * If a packet is corrupt, the framer resynchronizes on the very next start byte.  Every byte is examined at most a
+ * bounded number of times (once per candidate packet it could be part of), so resync is linear in the data size.
+ */
+class UsbFramer
+{
+public:
+    UsbFramer();
+
+    void reset();
+
+    // Note: data must remain valid until next() returns NULL
+    void feed(const uint8_t *data, size_t size);
+    const UsbPacket *next();
+
+    const UsbLinkStats &stats() const { return linkStats; }
+
+private:
+    const UsbPacket *nextPartial();
+    const UsbPacket *nextInChunk();
+    bool takeIntoPartial(size_t upTo);
+    void skipPartial(size_t count);
+    void resyncPartial();
+    void discard(size_t count);
+
+    const uint8_t *chunk;
+    size_t chunkSize;
+    size_t chunkPos;
+
+    // A packet that was split between two chunks.  partialStart is non-zero only if a packet from this buffer was just
+    // returned and some bytes after it are still to be examined.
+    uint8_t partial[sizeof(UsbPacket)];
+    size_t partialStart;
+    size_t partialSize;
+
+    UsbLinkStats linkStats;
+    bool synced;                // the last bytes looked at were a good packet
+};
+
+#endif // USB_FRAMER_H
@@ -0,0 +1,68 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USB_PROTOCOL_H
+#define USB_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+enum UsbPacketSpecial
+{
+    USB_PACKET_START_BYTE = 0x9A,
+    USB_PACKET_HEADER_SIZE = 4,
+    USB_PACKET_MAX_DATA_LENGTH = 60,
+};
+
+enum UsbCommands
+{
+    USB_COMMAND_READ_SENSORS = 0x61,
+    USB_COMMAND_AUTOSEND_SENSORS = 0x58,
+
+    USB_COMMAND_ENTER_BOOTLOADER = 0xE2,
+};
+
+// Sensor types occupy the higher 4 bits, the 2 bits lower than that identify finger, and the lower 2 bits is used as an index.
+enum UsbSensorType
+{
+    USB_SENSOR_TYPE_STATIC_TACTILE = 0x10,
+    USB_SENSOR_TYPE_DYNAMIC_TACTILE = 0x20,
+    USB_SENSOR_TYPE_ACCELEROMETER = 0x30,
+    USB_SENSOR_TYPE_GYROSCOPE = 0x40,
+    USB_SENSOR_TYPE_MAGNETOMETER = 0x50,
+    USB_SENSOR_TYPE_TEMPERATURE = 0x60,
+};
+
+struct UsbPacket
+{
+    uint8_t start_byte;
+    uint8_t crc8;           // over command, data_length and data
+    uint8_t command;        // 4 bits of flag (MSB) and 4 bits of command (LSB)
+    uint8_t data_length;
+    uint8_t data[USB_PACKET_MAX_DATA_LENGTH];
+};
+
+uint8_t calcCrc8(const uint8_t *data, size_t len);
+
+// Append a sensor's values (in big endian) to the data of a packet.  Returns false if they don't fit.
+bool usbAppendSensor(UsbPacket *packet, uint8_t sensorType, unsigned int finger, const uint16_t *values, unsigned int count);
+
+// Fill in the start byte and CRC of a packet whose command, data_length and data are set.  Returns the packet size.
+size_t usbFinalizePacket(UsbPacket *packet);
+
+#endif // USB_PROTOCOL_H
@@ -0,0 +1,186 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Checks that framing doesn't depend on how the stream is cut into chunks: the same bytes, given in one buffer or split
+ * in two at every possible point, must give the same packets and the same link statistics.  Exits with failure if not.
+ */
+
+#include "usb_framer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+struct FramingResult
+{
+    std::vector<std::vector<uint8_t> > packets;
+    UsbLinkStats stats;
+};
+
+// Frame a stream given as consecutive chunks of the given sizes
+static FramingResult frame(const std::vector<uint8_t> &stream, const std::vector<size_t> &chunkSizes)
+{
+    UsbFramer framer;
+    FramingResult result;
+    size_t pos = 0;
+
+    for (size_t c = 0; c < chunkSizes.size(); ++c)
+    {
+        // Copy the chunk, so that the framer can't be reading past it without this being caught by a memory checker
+        std::vector<uint8_t> chunk(stream.begin() + pos, stream.begin() + pos + chunkSizes[c]);
+        pos += chunkSizes[c];
+
+        // Reads never give empty chunks
+        if (chunk.empty())
+            continue;
+
+        const UsbPacket *packet;
+        framer.feed(&chunk[0], chunk.size());
+        while ((packet = framer.next()) != NULL)
+        {
+            const uint8_t *p = (const uint8_t *)packet;
+            result.packets.push_back(std::vector<uint8_t>(p, p + USB_PACKET_HEADER_SIZE + packet->data_length));
+        }
+    }
+
+    result.stats = framer.stats();
+    return result;
+}
+
+static bool sameResult(const FramingResult &a, const FramingResult &b)
+{
+    return a.packets == b.packets &&
+        a.stats.goodFrames == b.stats.goodFrames &&
+        a.stats.crcFailures == b.stats.crcFailures &&
+        a.stats.resyncs == b.stats.resyncs &&
+        a.stats.discardedBytes == b.stats.discardedBytes;
+}
+
+static void printResult(const char *name, const FramingResult &r)
+{
+    printf("  %s: %zu packets, %llu good, %llu CRC failures, %llu resyncs, %llu discarded\n", name, r.packets.size(),
+           (unsigned long long)r.stats.goodFrames, (unsigned long long)r.stats.crcFailures,
+           (unsigned long long)r.stats.resyncs, (unsigned long long)r.stats.discardedBytes);
+}
+
+// Frame the stream whole, and split in two at every point.  Returns the number of splits that gave a different result.
+static int checkSplits(const char *name, const std::vector<uint8_t> &stream, size_t expectedPackets,
+                       uint64_t expectedResyncs)
+{
+    std::vector<size_t> sizes(1, stream.size());
+    FramingResult whole = frame(stream, sizes);
+    int failures = 0;
+
+    if (whole.packets.size() != expectedPackets || whole.stats.resyncs != expectedResyncs)
+    {
+        printf("%s: unexpected result in one buffer\n", name);
+        printResult("whole", whole);
+        ++failures;
+    }
+
+    sizes.resize(2);
+    for (size_t split = 0; split <= stream.size(); ++split)
+    {
+        sizes[0] = split;
+        sizes[1] = stream.size() - split;
+        FramingResult cut = frame(stream, sizes);
+        if (!sameResult(whole, cut))
+        {
+            printf("%s: cut after byte %zu differs\n", name, split);
+            printResult("whole", whole);
+            printResult("cut", cut);
+            ++failures;
+        }
+    }
+
+    // Byte by byte is the worst case of splitting
+    sizes.assign(stream.size(), 1);
+    if (!sameResult(whole, frame(stream, sizes)))
+    {
+        printf("%s: byte by byte differs\n", name);
+        ++failures;
+    }
+
+    return failures;
+}
+
+static void appendPacket(std::vector<uint8_t> &stream, uint8_t command, const uint8_t *data, uint8_t length)
+{
+    UsbPacket packet;
+    packet.command = command;
+    packet.data_length = length;
+    memcpy(packet.data, data, length);
+    size_t size = usbFinalizePacket(&packet);
+    stream.insert(stream.end(), (uint8_t *)&packet, (uint8_t *)&packet + size);
+}
+
+int main()
+{
+    int failures = 0;
+
+    // A stream of valid and corrupt packets mixed with stray start bytes
+    static const uint8_t mixed[] =
+    {
+        0x9A, 0x60, 0x78, 0x04, 0x9A, 0x9A, 0x9A, 0x9A, 0x9A, 0x44, 0x58, 0x06, 0x9A, 0x9A, 0x9A, 0x02, 0x0B, 0x9A,
+        0x9A, 0xA4, 0x58, 0x00, 0x02, 0x9A, 0x9A, 0x3C, 0x58, 0x06, 0x9A, 0x9A, 0x01, 0x9A, 0x9A, 0x9A,
+    };
+    std::vector<uint8_t> stream(mixed, mixed + sizeof mixed);
+    failures += checkSplits("mixed", stream, 2, 1);
+
+    // Good packets with garbage, a corrupt CRC and a bad length in between, each of which loses sync once
+    static const uint8_t data[] = { 0x20, 0x00, 0x01, 0x00, 0x02, 0x9A, 0x9A, 0x00 };
+    static const uint8_t garbage[] = { 0x12, 0x9A, 0x34, 0x9A, 0x9A, 0xFF, 0x00 };
+    stream.clear();
+    appendPacket(stream, 0x01, data, sizeof data);
+    stream.insert(stream.end(), garbage, garbage + sizeof garbage);
+    appendPacket(stream, 0x01, data, sizeof data);
+    appendPacket(stream, 0x01, data, 3);
+    stream[stream.size() - 4] ^= 0x40;          // corrupt the CRC of the last packet
+    appendPacket(stream, 0x01, data, sizeof data);
+    stream.push_back(0x9A);
+    stream.push_back(0x00);
+    stream.push_back(0x01);
+    stream.push_back(USB_PACKET_MAX_DATA_LENGTH + 1);   // a header with a bad length
+    appendPacket(stream, 0x01, data, 0);
+    appendPacket(stream, 0x01, data, sizeof data);
+    failures += checkSplits("corrupt", stream, 5, 3);
+
+    // Random bytes, with many start bytes, and the occasional good packet
+    srand(1);
+    stream.clear();
+    for (int i = 0; i < 200; ++i)
+    {
+        if (rand() % 8 == 0)
+            appendPacket(stream, 0x01, data, rand() % (sizeof data + 1));
+        else
+            stream.push_back(rand() % 3 == 0?USB_PACKET_START_BYTE:rand() % 8);
+    }
+    std::vector<size_t> sizes(1, stream.size());
+    FramingResult whole = frame(stream, sizes);
+    failures += checkSplits("random", stream, whole.packets.size(), whole.stats.resyncs);
+
+    if (failures)
+    {
+        printf("%d failures\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    printf("All framings agree\n");
+    return EXIT_SUCCESS;
+}
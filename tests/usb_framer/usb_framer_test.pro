@@ -0,0 +1,26 @@
+#-------------------------------------------------
+#
+# Checks that framing gives the same packets and statistics wherever the stream is cut into chunks.  Run the built
+# program; it exits with failure if any framing differs.
+#
+#-------------------------------------------------
+
+QT -= core gui
+CONFIG += console
+CONFIG -= app_bundle
+
+# remove -Wextra
+CONFIG += warn_off
+QMAKE_CXXFLAGS += -Wall
+
+TARGET = usb_framer_test
+TEMPLATE = app
+
+INCLUDEPATH += ../../src
+
+SOURCES += usb_framer_test.cpp \
+    ../../src/usb_protocol.cpp \
+    ../../src/usb_framer.cpp
+
+HEADERS += ../../src/usb_protocol.h \
+    ../../src/usb_framer.h
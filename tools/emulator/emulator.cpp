@@ -0,0 +1,461 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Emulates the sensor board's firmware on a pseudo-terminal, so that the UI can connect to it as if it was a real board
+ * (type the printed pty path, or the --link path, in the port box).  The emulator answers USB_COMMAND_AUTOSEND_SENSORS
+ * and USB_COMMAND_READ_SENSORS, and can stream at periods below 1ms with a chosen mix of sensors, injected corruption
+ * and bursty delivery.  It is meant for soak testing throughput, CRC resync and buffer overruns.  Several instances can
+ * be run to emulate several boards.
+ *
+ * Example: stream every 250us with 1% corrupt packets, delivered in bursts of 8 samples, for 10 minutes:
+ *
+ *     CoRoSensorEmulator --period-us 250 --corrupt 0.01 --burst 8 --duration 600 --link /tmp/coro0
+ */
+
+#include "usb_protocol.h"
+#include "usb_framer.h"
+#include "finger_data.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#define MAX_FINGERS 4
+
+enum SensorMask
+{
+    SENSOR_STATIC = 1,
+    SENSOR_DYNAMIC = 2,
+    SENSOR_ACCELEROMETER = 4,
+    SENSOR_GYROSCOPE = 8,
+    SENSOR_MAGNETOMETER = 16,
+    SENSOR_TEMPERATURE = 32,
+    SENSOR_ALL = 63,
+};
+
+struct Options
+{
+    unsigned int fingers;
+    unsigned int sensors;       // SensorMask
+    int64_t periodOverride;     // ns, or 0 to use the period requested by the host
+    double corruptRate;         // fraction of packets with a flipped bit
+    double garbageRate;         // fraction of packets followed by random bytes
+    unsigned int burst;         // number of samples delivered at once
+    double duration;            // s, or 0 to run until interrupted
+    const char *link;           // path of a symlink to create to the pty
+    bool autostart;             // stream without waiting for the autosend command
+};
+
+struct Stats
+{
+    uint64_t samples;
+    uint64_t packets;
+    uint64_t bytes;
+    uint64_t corrupted;
+    uint64_t droppedBytes;      // bytes that could not be written because the reader didn't keep up
+    uint64_t lateWakeups;       // times the emulator itself fell behind by more than a period
+};
+
+static volatile sig_atomic_t quit = 0;
+
+static void onSignal(int)
+{
+    quit = 1;
+}
+
+static int64_t now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void sleepUntil(int64_t t)
+{
+    struct timespec ts;
+    ts.tv_sec = t / 1000000000;
+    ts.tv_nsec = t % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR && !quit)
+        ;
+}
+
+static double randomUniform()
+{
+    return rand() / (RAND_MAX + 1.0);
+}
+
+static int openPty(int *slave)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0)
+        return -1;
+
+    // Keep the slave open in raw mode, so that nothing is echoed back before the reader sets it up, and the master
+    // doesn't see a hang up between readers
+    *slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (*slave < 0)
+        return -1;
+
+    struct termios tio;
+    tcgetattr(*slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(*slave, TCSANOW, &tio);
+
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+    return master;
+}
+
+static void appendPacket(std::vector<uint8_t> &out, UsbPacket *packet, const Options &opts, Stats &stats)
+{
+    size_t size = usbFinalizePacket(packet);
+    size_t start = out.size();
+
+    out.insert(out.end(), (uint8_t *)packet, (uint8_t *)packet + size);
+    packet->data_length = 0;
+    ++stats.packets;
+
+    if (randomUniform() < opts.corruptRate)
+    {
+        out[start + 1 + rand() % (size - 1)] ^= 1 << rand() % 8;
+        ++stats.corrupted;
+    }
+
+    if (randomUniform() < opts.garbageRate)
+        for (int i = 1 + rand() % 16; i > 0; --i)
+            out.push_back(rand() & 0xFF);
+}
+
+static void addSensor(std::vector<uint8_t> &out, UsbPacket *packet, uint8_t sensorType, unsigned int finger,
+                      const uint16_t *values, unsigned int count, const Options &opts, Stats &stats)
+{
+    if (usbAppendSensor(packet, sensorType, finger, values, count))
+        return;
+
+    // Packet is full, send it and start a new one
+    appendPacket(out, packet, opts, stats);
+    usbAppendSensor(packet, sensorType, finger, values, count);
+}
+
+// Generate a plausible sample: a contact moving over the static array, a vibrating dynamic sensor and a rotating IMU
+static void buildSample(std::vector<uint8_t> &out, uint64_t n, int64_t period, const Options &opts, Stats &stats)
+{
+    double t = n * period * 1e-9;
+    uint16_t staticTactile[MAX_FINGERS][FINGER_STATIC_TACTILE_COUNT];
+    uint16_t dynamic[MAX_FINGERS];
+    uint16_t accel[MAX_FINGERS][3], gyro[MAX_FINGERS][3], mag[MAX_FINGERS][3];
+    uint16_t temperature[MAX_FINGERS];
+
+    for (unsigned int f = 0; f < opts.fingers; ++f)
+    {
+        double contact = (0.5 + 0.5 * sin(2 * M_PI * 0.2 * t + f)) * (FINGER_STATIC_TACTILE_COUNT - 1);
+        for (int i = 0; i < FINGER_STATIC_TACTILE_COUNT; ++i)
+            staticTactile[f][i] = (uint16_t)(20000 + 15000 * exp(-fabs(i - contact) / 3) + rand() % 64);
+
+        dynamic[f] = (uint16_t)(int16_t)(8000 * sin(2 * M_PI * 50 * t) + 2000 * sin(2 * M_PI * 230 * t) + rand() % 512 - 256);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            accel[f][i] = (uint16_t)(int16_t)(4000 * sin(2 * M_PI * 0.5 * t + i * 2.1) + rand() % 64 - 32);
+            gyro[f][i] = (uint16_t)(int16_t)(1000 * cos(2 * M_PI * 0.5 * t + i * 2.1) + rand() % 64 - 32);
+            mag[f][i] = (uint16_t)(int16_t)(300 * sin(2 * M_PI * 0.05 * t + i) + rand() % 8 - 4);
+        }
+
+        temperature[f] = 25 * 16 + n / 100000 % 16;
+    }
+
+    UsbPacket packet;
+    packet.command = USB_COMMAND_AUTOSEND_SENSORS;
+    packet.data_length = 0;
+
+    // The dynamic sensor is sent last, since it marks the end of a set of data
+    for (unsigned int f = 0; f < opts.fingers; ++f)
+        if (opts.sensors & SENSOR_STATIC)
+            addSensor(out, &packet, USB_SENSOR_TYPE_STATIC_TACTILE, f, staticTactile[f], FINGER_STATIC_TACTILE_COUNT, opts, stats);
+    for (unsigned int f = 0; f < opts.fingers; ++f)
+    {
+        if (opts.sensors & SENSOR_ACCELEROMETER)
+            addSensor(out, &packet, USB_SENSOR_TYPE_ACCELEROMETER, f, accel[f], 3, opts, stats);
+        if (opts.sensors & SENSOR_GYROSCOPE)
+            addSensor(out, &packet, USB_SENSOR_TYPE_GYROSCOPE, f, gyro[f], 3, opts, stats);
+        if (opts.sensors & SENSOR_MAGNETOMETER)
+            addSensor(out, &packet, USB_SENSOR_TYPE_MAGNETOMETER, f, mag[f], 3, opts, stats);
+        if (opts.sensors & SENSOR_TEMPERATURE)
+            addSensor(out, &packet, USB_SENSOR_TYPE_TEMPERATURE, f, &temperature[f], 1, opts, stats);
+    }
+    for (unsigned int f = 0; f < opts.fingers; ++f)
+        if (opts.sensors & SENSOR_DYNAMIC)
+            addSensor(out, &packet, USB_SENSOR_TYPE_DYNAMIC_TACTILE, f, &dynamic[f], 1, opts, stats);
+
+    if (packet.data_length > 0)
+        appendPacket(out, &packet, opts, stats);
+
+    ++stats.samples;
+}
+
+static void writeOut(int master, const std::vector<uint8_t> &out, Stats &stats)
+{
+    size_t written = 0;
+
+    while (written < out.size())
+    {
+        ssize_t w = write(master, out.data() + written, out.size() - written);
+        if (w < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            // The reader is not keeping up (or not there at all), so the rest is lost like a real overrun
+            break;
+        }
+        written += w;
+    }
+
+    stats.bytes += written;
+    stats.droppedBytes += out.size() - written;
+}
+
+static void printStats(const Stats &stats, const Stats &previous, double seconds)
+{
+    fprintf(stderr, "%.0f samples/s, %.1f KB/s, %llu samples, %llu packets, %llu corrupted, %llu bytes dropped, %llu late\n",
+            (stats.samples - previous.samples) / seconds, (stats.bytes - previous.bytes) / seconds / 1000,
+            (unsigned long long)stats.samples, (unsigned long long)stats.packets, (unsigned long long)stats.corrupted,
+            (unsigned long long)stats.droppedBytes, (unsigned long long)stats.lateWakeups);
+}
+
+static unsigned int parseSensors(const char *list)
+{
+    static const struct { const char *name; unsigned int mask; } names[] =
+    {
+        { "static", SENSOR_STATIC },
+        { "dynamic", SENSOR_DYNAMIC },
+        { "accel", SENSOR_ACCELEROMETER },
+        { "gyro", SENSOR_GYROSCOPE },
+        { "mag", SENSOR_MAGNETOMETER },
+        { "temp", SENSOR_TEMPERATURE },
+        { "all", SENSOR_ALL },
+    };
+
+    unsigned int mask = 0;
+    std::vector<char> copy(list, list + strlen(list) + 1);
+
+    for (char *name = strtok(copy.data(), ","); name; name = strtok(NULL, ","))
+    {
+        unsigned int i;
+        for (i = 0; i < sizeof names / sizeof names[0]; ++i)
+            if (strcmp(name, names[i].name) == 0)
+                break;
+        if (i == sizeof names / sizeof names[0])
+        {
+            fprintf(stderr, "Unknown sensor '%s'\n", name);
+            exit(EXIT_FAILURE);
+        }
+        mask |= names[i].mask;
+    }
+
+    return mask;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "\n"
+            "  --fingers N        number of fingers to emulate (1-%d, default 2)\n"
+            "  --sensors LIST     comma separated list of static, dynamic, accel, gyro, mag, temp or all (default all).\n"
+            "                     Note: the UI only completes a sample when it sees dynamic data\n"
+            "  --period-us N      sample period, overriding the one requested by the host\n"
+            "  --corrupt P        fraction of packets with a flipped bit (default 0)\n"
+            "  --garbage P        fraction of packets followed by random bytes (default 0)\n"
+            "  --burst N          deliver samples N at a time (default 1)\n"
+            "  --duration S       stop after S seconds\n"
+            "  --link PATH        create a symlink to the pty at PATH\n"
+            "  --autostart        start streaming without waiting for the host\n",
+            name, MAX_FINGERS);
+}
+
+int main(int argc, char *argv[])
+{
+    Options opts = { 2, SENSOR_ALL, 0, 0, 0, 1, 0, NULL, false };
+    Stats stats = { 0, 0, 0, 0, 0, 0 };
+
+    static const struct option longOptions[] =
+    {
+        { "fingers", required_argument, NULL, 'f' },
+        { "sensors", required_argument, NULL, 's' },
+        { "period-us", required_argument, NULL, 'p' },
+        { "corrupt", required_argument, NULL, 'c' },
+        { "garbage", required_argument, NULL, 'g' },
+        { "burst", required_argument, NULL, 'b' },
+        { "duration", required_argument, NULL, 'd' },
+        { "link", required_argument, NULL, 'l' },
+        { "autostart", no_argument, NULL, 'a' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "f:s:p:c:g:b:d:l:ah", longOptions, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'f': opts.fingers = atoi(optarg); break;
+        case 's': opts.sensors = parseSensors(optarg); break;
+        case 'p': opts.periodOverride = (int64_t)(atof(optarg) * 1000); break;
+        case 'c': opts.corruptRate = atof(optarg); break;
+        case 'g': opts.garbageRate = atof(optarg); break;
+        case 'b': opts.burst = atoi(optarg); break;
+        case 'd': opts.duration = atof(optarg); break;
+        case 'l': opts.link = optarg; break;
+        case 'a': opts.autostart = true; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h'?EXIT_SUCCESS:EXIT_FAILURE;
+        }
+    }
+
+    if (opts.fingers < 1 || opts.fingers > MAX_FINGERS || opts.burst < 1)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int slave;
+    int master = openPty(&slave);
+    if (master < 0)
+    {
+        perror("Could not open a pty");
+        return EXIT_FAILURE;
+    }
+
+    printf("%s\n", ptsname(master));
+    fflush(stdout);
+
+    if (opts.link)
+    {
+        unlink(opts.link);
+        if (symlink(ptsname(master), opts.link) < 0)
+            perror("Could not create link");
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    UsbFramer framer;
+    uint8_t command[256];
+    std::vector<uint8_t> out;
+
+    bool streaming = opts.autostart;
+    int64_t period = opts.periodOverride?opts.periodOverride:1000000;
+    uint64_t sampleIndex = 0;
+
+    int64_t begin = now();
+    int64_t next = begin;
+    int64_t lastReport = begin;
+    Stats lastReportStats = stats;
+
+    while (!quit)
+    {
+        int64_t t = now();
+
+        if (opts.duration > 0 && t - begin >= opts.duration * 1e9)
+            break;
+
+        if (t - lastReport >= 1000000000)
+        {
+            printStats(stats, lastReportStats, (t - lastReport) * 1e-9);
+            lastReport = t;
+            lastReportStats = stats;
+        }
+
+        // Wait for commands until it's time to deliver the next burst of samples
+        int64_t deliverAt = next + (int64_t)(opts.burst - 1) * period;
+        int timeout = streaming?(int)((deliverAt - t) / 1000000):100;
+        if (timeout < 0)
+            timeout = 0;
+
+        struct pollfd pfd;
+        pfd.fd = master;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, timeout) > 0 && (pfd.revents & POLLIN))
+        {
+            ssize_t r = read(master, command, sizeof command);
+            if (r > 0)
+            {
+                const UsbPacket *packet;
+
+                framer.feed(command, r);
+                while ((packet = framer.next()) != NULL)
+                {
+                    if (packet->command == USB_COMMAND_AUTOSEND_SENSORS && packet->data_length >= 1)
+                    {
+                        streaming = packet->data[0] != 0;
+                        if (!opts.periodOverride)
+                            period = (int64_t)packet->data[0] * 1000000;
+                        next = now();
+                        fprintf(stderr, streaming?"Autosend every %.3f ms\n":"Autosend stopped\n", period / 1e6);
+                    }
+                    else if (packet->command == USB_COMMAND_READ_SENSORS)
+                    {
+                        out.clear();
+                        buildSample(out, sampleIndex++, period, opts, stats);
+                        writeOut(master, out, stats);
+                    }
+                }
+            }
+            continue;
+        }
+
+        if (!streaming)
+            continue;
+
+        // Poll only has ms resolution, so sleep for the rest
+        sleepUntil(deliverAt);
+        t = now();
+        if (t - deliverAt > period)
+            ++stats.lateWakeups;
+
+        // Send all samples that are due.  If the emulator fell behind, it catches up like the firmware's sampling would.
+        out.clear();
+        while (next <= t)
+        {
+            buildSample(out, sampleIndex++, period, opts, stats);
+            next += period;
+        }
+        writeOut(master, out, stats);
+    }
+
+    printStats(stats, lastReportStats, (now() - lastReport) * 1e-9);
+
+    if (opts.link)
+        unlink(opts.link);
+    close(slave);
+    close(master);
+
+    return EXIT_SUCCESS;
+}
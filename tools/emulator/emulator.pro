@@ -0,0 +1,27 @@
+#-------------------------------------------------
+#
+# Firmware emulator on a pseudo-terminal, for load and soak testing without a sensor board.  Linux only.
+#
+#-------------------------------------------------
+
+QT -= core gui
+CONFIG += console
+CONFIG -= app_bundle
+
+# remove -Wextra
+CONFIG += warn_off
+QMAKE_CXXFLAGS += -Wall
+
+TARGET = CoRoSensorEmulator
+TEMPLATE = app
+
+INCLUDEPATH += ../../src
+
+SOURCES += emulator.cpp \
+    ../../src/usb_protocol.cpp \
+    ../../src/usb_framer.cpp
+
+HEADERS += ../../src/usb_protocol.h \
+    ../../src/usb_framer.h
+
+LIBS += -lm
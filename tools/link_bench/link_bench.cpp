@@ -0,0 +1,222 @@
+/*
+ * CoRo Tactile Sensor UI
+ * Copyright (C) 2016  Shahbaz Youssefi
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Measures what a serial backend of the UI costs: the CPU it uses while streaming and the delay with which it gives out
+ * the data.  It connects to a port like the UI does, asks for autosend and reads for a while, without doing anything
+ * else with the data.  Run it against the firmware emulator with a fixed period and no corruption, e.g.:
+ *
+ *     CoRoSensorEmulator --link /tmp/coro0 &
+ *     CoRoLinkBench --backend posix --duration 30 /tmp/coro0
+ *     CoRoLinkBench --backend qt --duration 30 /tmp/coro0
+ *
+ * The latency is measured against the emulator's schedule: it sends sample k at start + k * period on the same
+ * monotonic clock, so the arrival of sample k minus k * period is constant but for the delay.  Since start isn't known,
+ * the delay is given over the fastest sample.  It also includes the emulator's own wakeup jitter, which is the same for
+ * both backends.
+ */
+
+#include "serial_link.h"
+#include "usb_protocol.h"
+#include "usb_framer.h"
+#include "finger_data.h"
+#include <QCoreApplication>
+#include <algorithm>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <vector>
+
+static int64_t now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int64_t cpuTime()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return ((int64_t)usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000 +
+           ((int64_t)usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000;
+}
+
+// Whether a packet has dynamic data, which is what completes a set of samples in the UI
+static bool hasDynamic(const UsbPacket *packet)
+{
+    for (unsigned int i = 0; i < packet->data_length;)
+    {
+        uint8_t sensorType = packet->data[i++] & 0xF0;
+        unsigned int count;
+
+        switch (sensorType)
+        {
+        case USB_SENSOR_TYPE_DYNAMIC_TACTILE:
+            return true;
+        case USB_SENSOR_TYPE_STATIC_TACTILE:
+            count = FINGER_STATIC_TACTILE_COUNT;
+            break;
+        case USB_SENSOR_TYPE_ACCELEROMETER:
+        case USB_SENSOR_TYPE_GYROSCOPE:
+        case USB_SENSOR_TYPE_MAGNETOMETER:
+            count = 3;
+            break;
+        case USB_SENSOR_TYPE_TEMPERATURE:
+            count = 1;
+            break;
+        default:
+            return false;
+        }
+        i += 2 * count;
+    }
+
+    return false;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [options] port\n"
+            "\n"
+            "  --backend NAME     qt or posix (default posix)\n"
+            "  --period-ms N      sample period to ask for (default 1)\n"
+            "  --duration S       how long to read for (default 10)\n",
+            name);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    SerialBackend backend = SERIAL_BACKEND_POSIX;
+    unsigned int periodMs = 1;
+    double duration = 10;
+
+    static const struct option longOptions[] =
+    {
+        { "backend", required_argument, NULL, 'b' },
+        { "period-ms", required_argument, NULL, 'p' },
+        { "duration", required_argument, NULL, 'd' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "b:p:d:h", longOptions, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'b': backend = strcmp(optarg, "qt") == 0?SERIAL_BACKEND_QT:SERIAL_BACKEND_POSIX; break;
+        case 'p': periodMs = atoi(optarg); break;
+        case 'd': duration = atof(optarg); break;
+        default:
+            usage(argv[0]);
+            return opt == 'h'?EXIT_SUCCESS:EXIT_FAILURE;
+        }
+    }
+
+    if (optind != argc - 1 || periodMs < 1 || periodMs > 255)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    SerialLink *link = SerialLink::open(backend, argv[optind]);
+    if (link->error() != QSerialPort::NoError)
+    {
+        fprintf(stderr, "Could not open %s\n", argv[optind]);
+        delete link;
+        return EXIT_FAILURE;
+    }
+
+    UsbPacket send;
+    send.command = USB_COMMAND_AUTOSEND_SENSORS;
+    send.data_length = 1;
+    send.data[0] = periodMs;
+    size_t size = usbFinalizePacket(&send);
+    link->write((char *)&send, size);
+
+    UsbFramer framer;
+    std::vector<char> buffer(1024);
+    std::vector<int64_t> offsets;        // arrival of every set, minus its place in the schedule
+    int64_t period = (int64_t)periodMs * 1000000;
+    uint64_t reads = 0, emptyReads = 0;
+
+    int64_t begin = now();
+    int64_t cpuBegin = cpuTime();
+    int64_t end = begin + (int64_t)(duration * 1e9);
+
+    while (now() < end)
+    {
+        int64_t available = link->read(buffer);
+        int64_t arrival = now();
+        if (available < 0)
+        {
+            fprintf(stderr, "Read error\n");
+            break;
+        }
+
+        ++reads;
+        if (available == 0)
+        {
+            ++emptyReads;
+            continue;
+        }
+
+        const UsbPacket *packet;
+        framer.feed((const uint8_t *)buffer.data(), available);
+        while ((packet = framer.next()) != NULL)
+            if (packet->command == USB_COMMAND_AUTOSEND_SENSORS && hasDynamic(packet))
+                offsets.push_back(arrival - (int64_t)offsets.size() * period);
+    }
+
+    double elapsed = (now() - begin) * 1e-9;
+    double cpu = (cpuTime() - cpuBegin) * 1e-9;
+
+    send.data[0] = 0;
+    size = usbFinalizePacket(&send);
+    link->write((char *)&send, size);
+    delete link;
+
+    printf("%s backend: %zu samples in %.1f s, %llu reads (%llu empty), CPU %.2f%% of a core\n",
+           backend == SERIAL_BACKEND_QT?"Qt":"POSIX", offsets.size(), elapsed, (unsigned long long)reads,
+           (unsigned long long)emptyReads, cpu / elapsed * 100);
+
+    if (offsets.empty())
+        return EXIT_FAILURE;
+
+    // Delays over the fastest sample
+    int64_t fastest = *std::min_element(offsets.begin(), offsets.end());
+    std::vector<double> delays(offsets.size());
+    double sum = 0;
+    for (size_t i = 0; i < offsets.size(); ++i)
+    {
+        delays[i] = (offsets[i] - fastest) * 1e-6;
+        sum += delays[i];
+    }
+    std::sort(delays.begin(), delays.end());
+
+    printf("Delay over the fastest sample: mean %.3f ms, median %.3f ms, 99%% %.3f ms, max %.3f ms\n",
+           sum / delays.size(), delays[delays.size() / 2], delays[delays.size() * 99 / 100], delays.back());
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,29 @@
+#-------------------------------------------------
+#
+# Measures the CPU use and delivery delay of the serial backends, against the firmware emulator.  Linux only.
+#
+#-------------------------------------------------
+
+QT += core serialport
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+
+# remove -Wextra
+CONFIG += warn_off
+QMAKE_CXXFLAGS += -Wall
+
+TARGET = CoRoLinkBench
+TEMPLATE = app
+
+INCLUDEPATH += ../../src
+
+SOURCES += link_bench.cpp \
+    ../../src/serial_link.cpp \
+    ../../src/serial_link_posix.cpp \
+    ../../src/usb_protocol.cpp \
+    ../../src/usb_framer.cpp
+
+HEADERS += ../../src/serial_link.h \
+    ../../src/usb_protocol.h \
+    ../../src/usb_framer.h